@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+class MonotonicArena
+{
+    /* Bump allocator for data which lives as long as the arena (e.g. the interned names of a dictionary).
+    The memory is taken from chunks of at least chunk_size bytes, an allocation only moves the cursor
+    of the current chunk, so storing many small variable-length fields costs one heap allocation per chunk.
+    The individual allocations are never freed, all of them are freed with the arena.
+    */
+    private:
+        std::vector<std::unique_ptr<char[]>> chunks;
+        std::size_t chunk_size;
+        char* cursor = nullptr;         // next free byte of the last chunk
+        std::size_t remaining = 0;      // free bytes of the last chunk
+        std::size_t used = 0;           // bytes handed out
+
+        void add_chunk(std::size_t size)
+        {
+            chunks.emplace_back(new char[size]);
+            cursor = chunks.back().get();
+            remaining = size;
+        }
+
+    public:
+        explicit MonotonicArena(std::size_t chunk_size = 1 << 16): chunk_size{chunk_size} {}
+
+        MonotonicArena(const MonotonicArena&) = delete;
+        MonotonicArena& operator=(const MonotonicArena&) = delete;
+        MonotonicArena(MonotonicArena&&) = default;
+        MonotonicArena& operator=(MonotonicArena&&) = default;
+
+        void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+        {
+            /* :param alignment must be a power of two */
+            std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(cursor) % alignment) % alignment;
+            if (cursor == nullptr || padding + size > remaining)
+            {
+                add_chunk(std::max(chunk_size, size + alignment));
+                padding = (alignment - reinterpret_cast<std::uintptr_t>(cursor) % alignment) % alignment;
+            }
+            char* result = cursor + padding;
+            cursor = result + size;
+            remaining -= padding + size;
+            used += size;
+            return result;
+        }
+
+        std::string_view copy(std::string_view text)
+        {
+            /* :returns a view of the copy of the text in the arena, valid as long as the arena */
+            if (text.empty())
+            {
+                return std::string_view();
+            }
+            char* destination = static_cast<char*>(allocate(text.size(), 1));
+            std::memcpy(destination, text.data(), text.size());
+            return std::string_view(destination, text.size());
+        }
+
+        std::size_t getChunksNum() const { return chunks.size(); }
+
+        std::size_t getBytesUsed() const { return used; }
+};
@@ -0,0 +1,78 @@
+#include "allocation_counter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+// Replacement of all forms of the global operator new and delete, the plain, array, nothrow and aligned ones
+// and their sized counterparts, so every allocation is counted and released by the matching function
+
+static std::atomic<std::uint64_t> allocations{0};
+
+std::uint64_t allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+static void* allocate(std::size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* allocate(std::size_t size, std::align_val_t alignment) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = (size + align - 1) / align * align; // aligned_alloc requires a multiple of the alignment
+#ifdef _WIN32
+    return _aligned_malloc(rounded == 0 ? align : rounded, align);
+#else
+    return std::aligned_alloc(align, rounded == 0 ? align : rounded);
+#endif
+}
+
+static void release(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+static void release(void* pointer, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+static void* checked(void* pointer)
+{
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new(std::size_t size) { return checked(allocate(size)); }
+void* operator new[](std::size_t size) { return checked(allocate(size)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return checked(allocate(size, alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return checked(allocate(size, alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, alignment); }
+
+void operator delete(void* pointer) noexcept { release(pointer); }
+void operator delete[](void* pointer) noexcept { release(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete(void* pointer, std::align_val_t alignment) noexcept { release(pointer, alignment); }
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept { release(pointer, alignment); }
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept { release(pointer, alignment); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t alignment) noexcept { release(pointer, alignment); }
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept { release(pointer, alignment); }
+void operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept { release(pointer, alignment); }
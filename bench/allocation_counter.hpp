@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of calls of the global operator new (every form) since the start of the program.
+// The replacement operators live in allocation_counter.cpp, their own translation unit, so the compiler
+// cannot inline them into the callers and pair a new expression with the free inside operator delete.
+std::uint64_t allocation_count();
@@ -0,0 +1,96 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include "data_extractor.hpp"
+#include "correlation.hpp"
+#include "market_data_generator.hpp"
+
+// Cross-symbol correlation of the mid prices on a generated input: the as-of join with the grid,
+// the tiled multi-threaded product against the naive one, and the whole CorrelationEngine::correlate.
+// Usage: CorrelationBenchmark [rows] [symbols] [grid step in seconds]
+
+template <typename Function>
+static double measure(Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static void report(const std::string& name, double seconds)
+{
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds << " s" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    GeneratorOptions options;
+    options.rows = 2000000;
+    options.symbols = 1000;
+    std::int64_t step = 60;
+    if (argc > 1) { options.rows = std::strtoull(argv[1], nullptr, 10); }
+    if (argc > 2) { options.symbols = std::strtoull(argv[2], nullptr, 10); }
+    if (argc > 3) { step = std::strtoll(argv[3], nullptr, 10); }
+    if (options.symbols == 0 || step <= 0)
+    {
+        std::cerr << "Usage: CorrelationBenchmark [rows] [symbols] [grid step in seconds]" << std::endl;
+        return 1;
+    }
+    step *= Timestamp::nanoseconds_per_second;
+    const std::string input = "correlation_benchmark_input.csv";
+    if (!MarketDataGenerator(options).write(input))
+    {
+        std::cerr << "Failed to write file: " << input << std::endl;
+        return 1;
+    }
+    std::streambuf* output = std::cout.rdbuf(nullptr); // silence the progress messages of the parser
+    DataParser parser(input, 0);
+    parser.start(ReaderMode::MemoryMapped);
+    std::cout.rdbuf(output);
+    std::remove(input.c_str());
+
+    TimeIndex index = parser.build_time_index();
+    std::vector<SymbolId> symbols = parser.get_orders_table().get_symbol_ids();
+    TimeGrid grid = CorrelationEngine::common_grid(index, symbols, step);
+    std::cout << symbols.size() << " symbols, " << grid.points << " grid points, "
+              << std::thread::hardware_concurrency() << " threads" << std::endl;
+
+    std::vector<bool> moving;
+    std::vector<double> rows;
+    report("as-of join and returns", measure([&]() {
+        rows = CorrelationEngine::standardized_returns(index, symbols, grid, moving);
+    }));
+    std::size_t count = CorrelationEngine::padded(symbols.size());
+    std::size_t length = grid.points > 0 ? grid.points - 1 : 0;
+    std::vector<double> tiled(count * count);
+    std::vector<double> naive(count * count);
+    report("product (tiled, threads)", measure([&]() {
+        CorrelationEngine::multiply(rows.data(), count, length, tiled.data());
+    }));
+    report("product (tiled, 1 thread)", measure([&]() {
+        CorrelationEngine::multiply(rows.data(), count, length, tiled.data(), 1);
+    }));
+    report("product (naive)", measure([&]() {
+        CorrelationEngine::multiply_naive(rows.data(), count, length, naive.data());
+    }));
+    double difference = 0.0;
+    for (std::size_t i = 0; i < tiled.size(); i++)
+    {
+        difference = std::max(difference, std::fabs(tiled[i] - naive[i]));
+    }
+    std::cout << "largest difference between the products: " << std::scientific << difference << std::endl;
+
+    CorrelationMatrix matrix;
+    report("CorrelationEngine::correlate", measure([&]() {
+        matrix = CorrelationEngine::correlate(index, symbols, step);
+    }));
+    return difference < 1e-9 ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "market_data_generator.hpp"
+
+// Writes a deterministic synthetic input in the Sample_data.txt layout.
+// Usage: DataGenerator <file> [rows] [symbols] [trade ratio] [seed]
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: DataGenerator <file> [rows] [symbols] [trade ratio] [seed]" << std::endl;
+        return 1;
+    }
+    GeneratorOptions options;
+    if (argc > 2) { options.rows = std::strtoull(argv[2], nullptr, 10); }
+    if (argc > 3) { options.symbols = std::strtoull(argv[3], nullptr, 10); }
+    if (argc > 4) { options.trade_ratio = std::atof(argv[4]); }
+    if (argc > 5) { options.seed = std::strtoull(argv[5], nullptr, 10); }
+    if (options.symbols == 0)
+    {
+        std::cerr << "The number of symbols must be positive" << std::endl;
+        return 1;
+    }
+    MarketDataGenerator generator(options);
+    if (!generator.write(std::string(argv[1])))
+    {
+        std::cerr << "Failed to write file: " << argv[1] << std::endl;
+        return 1;
+    }
+    std::cout << options.rows << " rows of " << options.symbols << " symbols written to " << argv[1] << std::endl;
+    return 0;
+}
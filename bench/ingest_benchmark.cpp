@@ -0,0 +1,79 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include "data_extractor.hpp"
+
+// Throughput of the serial ingest, the parallel ingest for 1..N threads
+// and the sharded order table for 1..N shards (fed by the serial reader).
+// Usage: IngestBenchmark <file> [max threads]
+// The output of OrderTable::save of every parallel run is compared with the serial run.
+
+static std::string read_all(const std::string& path)
+{
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+static std::string run(const std::string& input, ReaderMode mode, unsigned int threads, unsigned int shards,
+                       double& seconds, int& orders)
+{
+    std::streambuf* output = std::cout.rdbuf(nullptr); // silence the progress messages of the parser
+    DataParser parser(input, 0);
+    parser.set_threads_num(threads);
+    parser.set_shards_num(shards);
+    auto start = std::chrono::steady_clock::now();
+    parser.start(mode);
+    auto end = std::chrono::steady_clock::now();
+    std::cout.rdbuf(output);
+    seconds = std::chrono::duration<double>(end - start).count();
+    orders = shards > 0 ? parser.get_sharded_table()->getTotalOrders() : parser.get_orders_table().getTotalOrders();
+    const std::string destination = "ingest_benchmark_output.txt";
+    parser.save_orders(destination);
+    std::string result = read_all(destination);
+    std::remove(destination.c_str());
+    return result;
+}
+
+static void report(const std::string& name, double seconds, int orders, double serial, bool identical)
+{
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds << " s" << std::setw(14) << std::setprecision(0) << orders / seconds
+              << " orders/s" << std::setw(8) << std::setprecision(2) << serial / seconds << "x"
+              << (identical ? "" : "  OUTPUT DIFFERS FROM SERIAL") << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: IngestBenchmark <file> [max threads]" << std::endl;
+        return 1;
+    }
+    std::string input = argv[1];
+    unsigned int max_threads = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2]))
+                                        : std::max(1u, std::thread::hardware_concurrency());
+    double seconds;
+    int orders;
+    std::string reference = run(input, ReaderMode::MemoryMapped, 1, 0, seconds, orders);
+    double serial = seconds;
+    report("serial", seconds, orders, serial, true);
+
+    for (unsigned int threads = 1; threads <= max_threads; threads++)
+    {
+        std::string result = run(input, ReaderMode::Parallel, threads, 0, seconds, orders);
+        report("parallel x" + std::to_string(threads), seconds, orders, serial, result == reference);
+    }
+    for (unsigned int shards = 1; shards <= max_threads; shards++)
+    {
+        std::string result = run(input, ReaderMode::MemoryMapped, 1, shards, seconds, orders);
+        report("sharded x" + std::to_string(shards), seconds, orders, serial, result == reference);
+    }
+    return 0;
+}
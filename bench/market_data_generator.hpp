@@ -0,0 +1,176 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+struct GeneratorOptions
+{
+    std::size_t rows = 1000000;
+    std::size_t symbols = 100;
+    double trade_ratio = 0.2;   // share of the trades, the rest are bid and ask changes in equal parts
+    double invalid_ratio = 0.0; // share of the rows with an unknown update type (e.g. 8 in Sample_data.txt)
+    std::vector<std::string> conditions = {"XT|O", "XT", "", "O", "R", "XT|R", "A"}; // "" is written as ",,@1"
+    std::uint32_t days = 3;     // consecutive trading days starting at 20150420
+    std::uint64_t seed = 1;
+};
+
+class MarketDataGenerator
+{
+    /* Deterministic synthetic market data in the column layout of Sample_data.txt:
+    symbol, id, bid, ask, trade, bid volume, ask volume, trade volume, update type, 0, date, seconds,
+    last trade, sequence, condition codes, @1
+    Every symbol follows its own random walk of the price in cents, the time advances by random gaps
+    from 08:00 of every day. The same options always produce the same file on every platform,
+    the random numbers come from splitmix64 instead of the implementation-defined std distributions.
+    */
+    private:
+        struct Symbol
+        {
+            std::string name;
+            std::int64_t mid;        // cents
+            std::int64_t last_trade; // cents
+        };
+
+        GeneratorOptions options;
+        std::uint64_t state;
+        std::vector<Symbol> symbols;
+
+        std::uint64_t next()
+        {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        std::uint64_t uniform(std::uint64_t bound) { return next() % bound; }
+
+        double unit() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+        static void append_cents(std::string& line, std::int64_t cents)
+        {
+            /* 15810 -> "158.1", 15600 -> "156.0", 15812 -> "158.12" */
+            line += std::to_string(cents / 100);
+            line += '.';
+            std::int64_t fraction = cents % 100;
+            line += static_cast<char>('0' + fraction / 10);
+            if (fraction % 10 != 0)
+            {
+                line += static_cast<char>('0' + fraction % 10);
+            }
+        }
+
+    public:
+        explicit MarketDataGenerator(const GeneratorOptions& options = GeneratorOptions()):
+            options{options}, state{options.seed}
+        {
+            static const char* const exchanges[] = {"NO", "SS", "DC", "FH"};
+            for (std::size_t i = 0; i < options.symbols; i++)
+            {
+                std::string name = "S" + std::to_string(i) + " " + exchanges[i % 4] + " Equity";
+                std::int64_t mid = 1000 + static_cast<std::int64_t>(uniform(50000));
+                symbols.push_back(Symbol{name, mid, mid});
+            }
+        }
+
+        void write(std::ostream& output)
+        {
+            std::string line;
+            std::uint32_t days = options.days == 0 ? 1 : options.days;
+            std::size_t rows_per_day = options.rows / days + 1;
+            std::size_t written = 0;
+            for (std::uint32_t day = 0; day < days && written < options.rows; day++)
+            {
+                std::uint32_t date = 20150420 + day;
+                std::int64_t milliseconds = 28800000; // 08:00
+                for (std::size_t i = 0; i < rows_per_day && written < options.rows; i++, written++)
+                {
+                    milliseconds += static_cast<std::int64_t>(uniform(800));
+                    Symbol& symbol = symbols[uniform(symbols.size())];
+                    symbol.mid += static_cast<std::int64_t>(uniform(7)) - 3;
+                    if (symbol.mid < 100)
+                    {
+                        symbol.mid = 100;
+                    }
+                    std::int64_t spread = 1 + static_cast<std::int64_t>(uniform(10));
+                    std::int64_t bid = symbol.mid - spread / 2;
+                    std::int64_t ask = bid + spread;
+
+                    double kind = unit();
+                    int update_type;
+                    if (kind < options.invalid_ratio)
+                    {
+                        update_type = 8;
+                    }
+                    else if (kind < options.invalid_ratio + options.trade_ratio)
+                    {
+                        update_type = 1;
+                        symbol.last_trade = symbol.mid;
+                    }
+                    else
+                    {
+                        update_type = uniform(2) == 0 ? 2 : 3;
+                    }
+                    std::uint64_t trade_volume = update_type == 1 ? 1 + uniform(5000) : 0;
+                    const std::string& condition = options.conditions.empty()
+                                                 ? std::string() : options.conditions[uniform(options.conditions.size())];
+
+                    line.clear();
+                    line += symbol.name;
+                    line += ',';
+                    line += std::to_string(1 + uniform(9999));
+                    line += ',';
+                    append_cents(line, bid);
+                    line += ',';
+                    append_cents(line, ask);
+                    line += ',';
+                    append_cents(line, symbol.last_trade);
+                    line += ',';
+                    line += std::to_string(1 + uniform(90000));
+                    line += ',';
+                    line += std::to_string(1 + uniform(90000));
+                    line += ',';
+                    line += std::to_string(trade_volume);
+                    line += ',';
+                    line += std::to_string(update_type);
+                    line += ",0,";
+                    line += std::to_string(date);
+                    line += ',';
+                    line += std::to_string(milliseconds / 1000);
+                    line += '.';
+                    if (milliseconds % 1000 == 0)
+                    {
+                        line += '0';
+                    }
+                    else
+                    {
+                        std::string fraction = std::to_string(1000 + milliseconds % 1000).substr(1);
+                        line += fraction;
+                    }
+                    line += ',';
+                    append_cents(line, symbol.last_trade);
+                    line += ',';
+                    line += std::to_string(written + 1);
+                    line += ',';
+                    line += condition;
+                    line += ",@1\n";
+                    output.write(line.data(), static_cast<std::streamsize>(line.size()));
+                }
+            }
+        }
+
+        bool write(const std::string& path)
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                return false;
+            }
+            write(file);
+            return file.good();
+        }
+};
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include "order_book.hpp"
+
+// Copy and memory-traffic cost of the compact Order record against the previous layout
+// (three std::string members, double prices, time_point) that was passed by value through the book,
+// and a single-column scan over the rows storage against the columnar storage.
+
+class LegacyOrder
+{
+    public:
+        std::string symbol;
+        double bid_price;
+        double ask_price;
+        double trade_price;
+        unsigned int bid_volume;
+        unsigned int ask_volume;
+        unsigned int trade_volume;
+        std::string condition_code;
+        UpdateType type;
+        std::string date;
+        std::chrono::system_clock::time_point time;
+        double getBidPrice() const { return bid_price; }
+        double getAskPrice() const { return ask_price; }
+};
+
+template <typename T>
+static double pass_by_value(T order) { return order.getAskPrice() - order.getBidPrice(); }
+
+template <typename T>
+static double copy_chain(const T& order)
+{
+    // the previous hot path copied the order into addOrder, analyze and the three statistic functions
+    return pass_by_value(order) + pass_by_value(order) + pass_by_value(order) + pass_by_value(order);
+}
+
+template <typename Function>
+static double nanoseconds_per_row(std::size_t rows, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / rows;
+}
+
+template <typename T>
+static void run(const char* name, const std::vector<T>& source, const std::vector<std::uint32_t>& shuffled)
+{
+    const std::size_t rows = source.size();
+    double checksum = 0.0;
+    std::vector<T> copy;
+    double copy_ns = nanoseconds_per_row(rows, [&]() {
+        copy.reserve(rows);
+        for (const T& order : source) { copy.push_back(order); }
+    });
+    double chain_ns = nanoseconds_per_row(rows, [&]() {
+        for (const T& order : source) { checksum += copy_chain(order); }
+    });
+    double scan_ns = nanoseconds_per_row(rows, [&]() {
+        for (const T& order : copy) { checksum += order.getBidPrice(); }
+    });
+    double random_ns = nanoseconds_per_row(rows, [&]() {
+        for (std::uint32_t index : shuffled) { checksum += copy[index].getBidPrice(); }
+    });
+    std::cout << std::left << std::setw(14) << name << std::right << std::setw(8) << sizeof(T)
+              << std::setw(8) << (sizeof(T) + 63) / 64 << std::fixed << std::setprecision(2)
+              << std::setw(12) << copy_ns << std::setw(12) << chain_ns << std::setw(12) << scan_ns
+              << std::setw(12) << random_ns << "   (checksum " << std::setprecision(0) << checksum << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t rows = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    std::mt19937 random(7);
+    SymbolId symbol = SymbolDictionary::global().intern("STL NO Equity");
+    ConditionId condition = static_cast<ConditionId>(SymbolDictionary::conditions().intern("XT|O"));
+
+    std::vector<LegacyOrder> legacy;
+    std::vector<Order> compact;
+    legacy.reserve(rows);
+    compact.reserve(rows);
+    for (std::size_t i = 0; i < rows; i++)
+    {
+        std::int64_t bid = 1550000 + random() % 1000;
+        std::int64_t time = 1429488000LL * 1000000000LL + static_cast<std::int64_t>(i) * 1000000;
+        UpdateType type = static_cast<UpdateType>(random() % 3);
+        legacy.push_back(LegacyOrder{"STL NO Equity", Order::to_price(bid), Order::to_price(bid + 100), 156.0,
+                                     6951, 55896, 114, "XT|O", type, "20150420",
+                                     std::chrono::system_clock::time_point(std::chrono::duration_cast<
+                                         std::chrono::system_clock::duration>(std::chrono::nanoseconds(time)))});
+        compact.push_back(Order(symbol, bid, bid + 100, 1560000, 6951, 55896, 114, condition, type, 20150420, time));
+    }
+    std::vector<std::uint32_t> shuffled(rows);
+    for (std::size_t i = 0; i < rows; i++) { shuffled[i] = static_cast<std::uint32_t>(i); }
+    std::shuffle(shuffled.begin(), shuffled.end(), random);
+
+    std::cout << rows << " orders, ns per order" << std::endl;
+    std::cout << std::left << std::setw(14) << "layout" << std::right << std::setw(8) << "bytes" << std::setw(8) << "lines"
+              << std::setw(12) << "copy" << std::setw(12) << "4x by-value" << std::setw(12) << "seq scan"
+              << std::setw(12) << "random" << std::endl;
+    run("legacy Order", legacy, shuffled);
+    run("compact Order", compact, shuffled);
+
+    // post-hoc analytics over the rows storage against the columnar storage of a book
+    OrderColumns columns;
+    for (const Order& order : compact) { columns.push_back(order); }
+    std::int64_t rows_sum = 0;
+    std::int64_t columns_sum = 0;
+    double rows_ns = nanoseconds_per_row(rows, [&]() {
+        for (const Order& order : compact) { rows_sum += order.getAskTicks() - order.getBidTicks(); }
+    });
+    double columns_ns = nanoseconds_per_row(rows, [&]() { columns_sum = columns.spread_sum(); });
+    std::cout << "\nspread sum, ns per order: rows " << std::setprecision(3) << rows_ns
+              << ", columns " << columns_ns << (rows_sum == columns_sum ? "" : "  (MISMATCH)") << std::endl;
+    return 0;
+}
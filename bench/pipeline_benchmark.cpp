@@ -0,0 +1,261 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include "data_extractor.hpp"
+#include "market_data_generator.hpp"
+#include "allocation_counter.hpp"
+
+// Micro benchmarks of the stages of the pipeline (parse_line, OrderTable::processOrder, OrderBook::analyze,
+// OrderTable::save, also for reduced metric sets) and macro benchmarks of the whole ingest in every reader mode, on a generated input.
+// Usage: PipelineBenchmark [rows] [symbols] [trade ratio]
+
+// Every call of the global operator new is counted (allocation_counter.cpp), the allocations of a stage are reported per row
+static std::uint64_t measured_allocations = 0; // allocations of the last measured function
+
+static void report(const std::string& name, double seconds, std::size_t rows)
+{
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds << " s" << std::setw(14) << std::setprecision(0) << rows / seconds
+              << " rows/s" << std::setw(12) << std::setprecision(1) << seconds * 1e9 / rows << " ns/row"
+              << std::setw(12) << measured_allocations << " allocs" << std::setw(10) << std::setprecision(4)
+              << static_cast<double>(measured_allocations) / rows << " allocs/row" << std::endl;
+}
+
+template <typename Function>
+static double measure(Function function)
+{
+    std::uint64_t allocated = allocation_count();
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    measured_allocations = allocation_count() - allocated;
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static std::vector<std::string> read_lines(const std::string& path)
+{
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+#ifdef ORDERBOOK_ZLIB
+static bool compress(const std::string& source, const std::string& destination)
+{
+    std::ifstream input(source, std::ios::binary);
+    gzFile output = gzopen(destination.c_str(), "wb");
+    if (!input || output == nullptr)
+    {
+        std::cerr << "Failed to write file: " << destination << std::endl;
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    while (input.read(buffer.data(), buffer.size()) || input.gcount() > 0)
+    {
+        gzwrite(output, buffer.data(), static_cast<unsigned int>(input.gcount()));
+    }
+    return gzclose(output) == Z_OK;
+}
+#endif
+
+template <unsigned int Set>
+static double analyze(const std::vector<std::vector<Order>>& grouped)
+{
+    // BasicOrderBook::analyze of the metric set "Set", the orders grouped by symbol beforehand
+    std::vector<BasicOrderBook<Set>> books;
+    for (std::size_t id = 0; id < grouped.size(); id++)
+    {
+        books.emplace_back(static_cast<SymbolId>(id));
+    }
+    return measure([&]() {
+        for (std::size_t id = 0; id < grouped.size(); id++)
+        {
+            for (const Order& order : grouped[id])
+            {
+                books[id].analyze(order);
+            }
+        }
+    });
+}
+
+static void macro(const std::string& name, const std::vector<std::string>& inputs, ReaderMode mode, std::size_t rows)
+{
+    std::streambuf* output = std::cout.rdbuf(nullptr); // silence the progress messages of the parser
+    DataParser parser(inputs, 0);
+    double seconds = measure([&]() { parser.start(mode); });
+    std::cout.rdbuf(output);
+    report(name, seconds, rows);
+}
+
+int main(int argc, char** argv)
+{
+    GeneratorOptions options;
+    if (argc > 1) { options.rows = std::strtoull(argv[1], nullptr, 10); }
+    if (argc > 2) { options.symbols = std::strtoull(argv[2], nullptr, 10); }
+    if (argc > 3) { options.trade_ratio = std::atof(argv[3]); }
+    if (options.symbols == 0)
+    {
+        std::cerr << "Usage: PipelineBenchmark [rows] [symbols] [trade ratio]" << std::endl;
+        return 1;
+    }
+    const std::string input = "pipeline_benchmark_input.csv";
+    const std::string destination = "pipeline_benchmark_output.txt";
+    MarketDataGenerator generator(options);
+    if (!generator.write(input))
+    {
+        std::cerr << "Failed to write file: " << input << std::endl;
+        return 1;
+    }
+    std::vector<std::string> lines = read_lines(input);
+    std::cout << lines.size() << " rows, " << options.symbols << " symbols" << std::endl;
+
+    // parse_line: split and convert the fields, without and with the order table
+    std::vector<Order> orders;
+    orders.reserve(lines.size());
+    InternCache cache;
+    double seconds = measure([&]() {
+        std::array<std::string_view, 16> fields;
+        for (const std::string& line : lines)
+        {
+            std::size_t count = DataParser::split_line(line, fields);
+            std::optional<Order> order = DataParser::parse_order(fields, count, cache);
+            if (order)
+            {
+                orders.push_back(*order);
+            }
+        }
+    });
+    report("parse_line (parse only)", seconds, lines.size());
+    {
+        std::streambuf* output = std::cout.rdbuf(nullptr);
+        DataParser parser(input, 0);
+        std::cout.rdbuf(output);
+        seconds = measure([&]() {
+            for (const std::string& line : lines)
+            {
+                parser.parse_line(line);
+            }
+        });
+        report("parse_line", seconds, lines.size());
+    }
+
+    // OrderTable::processOrder over the parsed orders
+    OrderTable table;
+    seconds = measure([&]() {
+        for (const Order& order : orders)
+        {
+            table.processOrder(order);
+        }
+    });
+    report("OrderTable::processOrder", seconds, orders.size());
+
+    // OrderBook::analyze, the orders grouped by symbol beforehand
+    std::vector<std::vector<Order>> grouped;
+    for (const Order& order : orders)
+    {
+        if (grouped.size() <= order.getSymbolId())
+        {
+            grouped.resize(order.getSymbolId() + 1);
+        }
+        grouped[order.getSymbolId()].push_back(order);
+    }
+    report("OrderBook::analyze", analyze<Metrics::All>(grouped), orders.size());
+    report("analyze (spreads only)", analyze<Metrics::Spreads>(grouped), orders.size());
+    report("analyze (trade gaps only)", analyze<Metrics::TradeGaps>(grouped), orders.size());
+
+    // OrderTable::save of a reduced metric set
+    BasicOrderTable<Metrics::Spreads | Metrics::TradeGaps> reduced;
+    for (const Order& order : orders)
+    {
+        reduced.processOrder(order);
+    }
+
+    // OrderTable::save, per output row (symbol)
+    const int repetitions = 20;
+    std::streambuf* output = std::cout.rdbuf(nullptr);
+    seconds = measure([&]() {
+        for (int i = 0; i < repetitions; i++)
+        {
+            table.save(destination);
+        }
+    });
+    std::cout.rdbuf(output);
+    report("OrderTable::save", seconds, repetitions * static_cast<std::size_t>(table.getSymbolsNum()));
+    seconds = measure([&]() {
+        for (int i = 0; i < repetitions; i++)
+        {
+            table.save(destination, SummaryFormat::Csv);
+        }
+    });
+    report("OrderTable::save (csv)", seconds, repetitions * static_cast<std::size_t>(table.getSymbolsNum()));
+    seconds = measure([&]() {
+        for (int i = 0; i < repetitions; i++)
+        {
+            reduced.save(destination);
+        }
+    });
+    report("save (spreads, trade gaps)", seconds, repetitions * static_cast<std::size_t>(table.getSymbolsNum()));
+
+    // checkpoint of the analytic state of the table, per order it replaces
+    const std::string checkpoint = destination + ".checkpoint";
+    seconds = measure([&]() { table.save_checkpoint(checkpoint); });
+    report("OrderTable::save_checkpoint", seconds, orders.size());
+    OrderTable resumed;
+    seconds = measure([&]() { resumed.load_checkpoint(checkpoint); });
+    report("OrderTable::load_checkpoint", seconds, orders.size());
+    std::remove(checkpoint.c_str());
+
+    // whole ingest
+    macro("ingest stream", {input}, ReaderMode::Stream, lines.size());
+    macro("ingest memory mapped", {input}, ReaderMode::MemoryMapped, lines.size());
+    macro("ingest parallel", {input}, ReaderMode::Parallel, lines.size());
+    std::remove((input + ".cache").c_str());
+    macro("ingest cached (first run)", {input}, ReaderMode::Cached, lines.size());
+    macro("ingest cached", {input}, ReaderMode::Cached, lines.size());
+#ifdef ORDERBOOK_ZLIB
+    // the same input compressed with gzip, inflated on the decompression thread while the rows are parsed
+    const std::string compressed = input + ".gz";
+    if (compress(input, compressed))
+    {
+        macro("ingest gzip", {compressed}, ReaderMode::Compressed, lines.size());
+    }
+    std::remove(compressed.c_str());
+#endif
+
+    // the input split into files by line, read on one thread each and merged by the timestamp
+    const std::size_t files_num = 4;
+    std::vector<std::string> parts;
+    {
+        std::vector<std::ofstream> files;
+        for (std::size_t i = 0; i < files_num; i++)
+        {
+            parts.push_back(input + "." + std::to_string(i));
+            files.emplace_back(parts.back());
+        }
+        for (std::size_t i = 0; i < lines.size(); i++)
+        {
+            files[i % files_num] << lines[i] << '\n';
+        }
+    }
+    macro("ingest merged (4 files)", parts, ReaderMode::Merged, lines.size());
+    for (const std::string& part : parts)
+    {
+        std::remove(part.c_str());
+    }
+
+    std::remove((input + ".cache").c_str());
+    std::remove(input.c_str());
+    std::remove(destination.c_str());
+    return 0;
+}
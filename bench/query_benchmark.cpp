@@ -0,0 +1,171 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include "data_extractor.hpp"
+#include "market_data_generator.hpp"
+
+// Random point-in-time queries (as-of quote, trades within an interval) against the TimeIndex of a loaded table,
+// compared with a linear walk over the retained orders of the book.
+// Usage: QueryBenchmark [rows] [symbols] [queries]
+
+static std::uint64_t state = 42;
+
+static std::uint64_t next_random()
+{
+    // splitmix64, as MarketDataGenerator
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+struct Query
+{
+    SymbolId symbol;
+    std::int64_t time;
+};
+
+static bool linear_quote(const OrderBook& book, std::int64_t time, QuoteSnapshot& quote)
+{
+    bool found = false;
+    for (const Order& order : book.get_orders())
+    {
+        if (order.getTime() <= time && (!found || order.getTime() >= quote.time))
+        {
+            quote = QuoteSnapshot{order.getTime(), order.getBidTicks(), order.getAskTicks(),
+                                  order.getBidVolume(), order.getAskVolume()};
+            found = true;
+        }
+    }
+    return found;
+}
+
+static std::size_t linear_trades(const OrderBook& book, std::int64_t begin, std::int64_t end)
+{
+    std::size_t count = 0;
+    for (const Order& order : book.get_orders())
+    {
+        count += order.getType() == UpdateType::Trade && order.getTime() >= begin && order.getTime() <= end;
+    }
+    return count;
+}
+
+static void report(const std::string& name, double seconds, std::size_t queries)
+{
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds << " s" << std::setw(14) << std::setprecision(0) << queries / seconds
+              << " queries/s" << std::setw(12) << std::setprecision(1) << seconds * 1e9 / queries << " ns/query" << std::endl;
+}
+
+template <typename Function>
+static double measure(Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    GeneratorOptions options;
+    std::size_t queries_num = 2000000;
+    if (argc > 1) { options.rows = std::strtoull(argv[1], nullptr, 10); }
+    if (argc > 2) { options.symbols = std::strtoull(argv[2], nullptr, 10); }
+    if (argc > 3) { queries_num = std::strtoull(argv[3], nullptr, 10); }
+    if (options.symbols == 0 || queries_num == 0)
+    {
+        std::cerr << "Usage: QueryBenchmark [rows] [symbols] [queries]" << std::endl;
+        return 1;
+    }
+    const std::string input = "query_benchmark_input.csv";
+    if (!MarketDataGenerator(options).write(input))
+    {
+        std::cerr << "Failed to write file: " << input << std::endl;
+        return 1;
+    }
+    std::streambuf* output = std::cout.rdbuf(nullptr); // silence the progress messages of the parser
+    DataParser parser(input, 0);
+    parser.start(ReaderMode::MemoryMapped);
+    std::cout.rdbuf(output);
+    std::remove(input.c_str());
+
+    const OrderTable& table = parser.get_orders_table();
+    TimeIndex index;
+    double seconds = measure([&]() { index = parser.build_time_index(); });
+    std::cout << table.getTotalOrders() << " orders, " << table.getSymbolsNum() << " symbols, index built in "
+              << std::fixed << std::setprecision(3) << seconds << " s" << std::endl;
+
+    // the queries cover the whole time span of the data and a little before and after it
+    std::vector<SymbolId> ids = table.get_symbol_ids();
+    std::int64_t first = INT64_MAX;
+    std::int64_t last = INT64_MIN;
+    for (SymbolId id : ids)
+    {
+        for (const Order& order : table.get_book(id).get_orders())
+        {
+            first = std::min(first, order.getTime());
+            last = std::max(last, order.getTime());
+        }
+    }
+    const std::int64_t margin = 3600 * Timestamp::nanoseconds_per_second;
+    const std::int64_t interval = 60 * Timestamp::nanoseconds_per_second; // length of the trade ranges
+    std::vector<Query> queries(queries_num);
+    for (Query& query : queries)
+    {
+        query.symbol = ids[next_random() % ids.size()];
+        query.time = first - margin + static_cast<std::int64_t>(next_random() % static_cast<std::uint64_t>(last - first + 2 * margin));
+    }
+
+    // the index against the linear walk on a sample of the queries
+    const std::size_t checked = std::min<std::size_t>(queries_num, 2000);
+    std::size_t mismatches = 0;
+    std::size_t found = 0;
+    std::size_t trades = 0;
+    double linear_seconds = measure([&]() {
+        for (std::size_t i = 0; i < checked; i++)
+        {
+            const OrderBook& book = table.get_book(queries[i].symbol);
+            QuoteSnapshot expected{};
+            QuoteSnapshot actual{};
+            bool expected_found = linear_quote(book, queries[i].time, expected);
+            bool actual_found = index.quote_at(queries[i].symbol, queries[i].time, actual);
+            if (expected_found != actual_found || (expected_found && (expected.time != actual.time
+                || expected.bid_price != actual.bid_price || expected.ask_price != actual.ask_price)))
+            {
+                mismatches++;
+            }
+            if (linear_trades(book, queries[i].time, queries[i].time + interval)
+                != index.trades_between(queries[i].symbol, queries[i].time, queries[i].time + interval).size)
+            {
+                mismatches++;
+            }
+        }
+    });
+    std::cout << checked << " queries checked against the linear walk, " << mismatches << " mismatches" << std::endl;
+    report("linear walk (check)", linear_seconds, checked);
+
+    seconds = measure([&]() {
+        for (const Query& query : queries)
+        {
+            QuoteSnapshot quote;
+            found += index.quote_at(query.symbol, query.time, quote);
+        }
+    });
+    report("as-of quote", seconds, queries_num);
+
+    seconds = measure([&]() {
+        for (const Query& query : queries)
+        {
+            trades += index.trades_between(query.symbol, query.time, query.time + interval).size;
+        }
+    });
+    report("trades in 60 s", seconds, queries_num);
+    std::cout << found << " quotes found, " << trades << " trades in the ranges" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
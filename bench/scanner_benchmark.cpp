@@ -0,0 +1,96 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include "data_extractor.hpp"
+
+// Micro-benchmark of the delimiter scanner kernels against the per-line scalar tokenizer.
+// Usage: ScannerBenchmark [file]   (without a file a synthetic buffer in the Sample_data.txt layout is used)
+
+static std::string synthetic_buffer(std::size_t rows)
+{
+    std::mt19937 random(42);
+    std::string buffer;
+    buffer.reserve(rows * 100);
+    const char* symbols[] = {"STL NO Equity", "PGS NO Equity", "ABB SS Equity", "AKA NO Equity"};
+    const char* conditions[] = {"XT|O", "", "XT", "R"};
+    for (std::size_t i = 0; i < rows; i++)
+    {
+        buffer += symbols[random() % 4];
+        buffer += "," + std::to_string(random() % 10000) + ",158.1,155.0,156.0,"
+                + std::to_string(random() % 100000) + "," + std::to_string(random() % 100000) + ",114,"
+                + std::to_string(random() % 3 + 1) + ",0,20150420," + std::to_string(28800 + i / 10) + ".0,156.0,"
+                + std::to_string(random() % 1000000) + "," + conditions[random() % 4] + ",@1\n";
+    }
+    return buffer;
+}
+
+template <typename Function>
+static double measure(Function function, int repetitions)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++)
+    {
+        function();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count() / repetitions;
+}
+
+int main(int argc, char** argv)
+{
+    std::string buffer;
+    if (argc > 1)
+    {
+        MappedFile file(argv[1]);
+        buffer.assign(file.data(), file.size());
+    }
+    else
+    {
+        buffer = synthetic_buffer(1000000);
+    }
+    const int repetitions = 5;
+    const double megabytes = static_cast<double>(buffer.size()) / (1 << 20);
+    std::vector<std::uint32_t> positions(buffer.size());
+    std::cout << "Buffer: " << std::fixed << std::setprecision(1) << megabytes << " MB" << std::endl;
+
+    // reference: per-line scalar split used by DataParser::parse_line
+    std::size_t reference = 0;
+    double seconds = measure([&]() {
+        std::array<std::string_view, 16> fields;
+        std::string_view content(buffer);
+        std::size_t position = 0;
+        reference = 0;
+        while (position < content.size())
+        {
+            std::size_t end = content.find('\n', position);
+            if (end == std::string_view::npos) { end = content.size(); }
+            reference += DataParser::split_line(content.substr(position, end - position), fields);
+            position = end + 1;
+        }
+    }, repetitions);
+    std::cout << std::left << std::setw(12) << "split_line" << std::right << std::setw(10) << std::setprecision(1)
+              << megabytes / seconds << " MB/s  (" << reference << " fields)" << std::endl;
+
+    const std::pair<ScannerKind, const char*> kinds[] = {
+        {ScannerKind::Scalar, "scalar"}, {ScannerKind::SSE2, "sse2"}, {ScannerKind::AVX2, "avx2"}};
+    std::size_t expected = DelimiterScanner::scan_scalar(buffer.data(), buffer.size(), positions.data());
+    for (const auto& kind : kinds)
+    {
+        if (!DelimiterScanner::supports(kind.first))
+        {
+            std::cout << std::left << std::setw(12) << kind.second << "not supported by this CPU" << std::endl;
+            continue;
+        }
+        DelimiterScanner::Kernel kernel = DelimiterScanner::kernel(kind.first);
+        std::size_t found = 0;
+        seconds = measure([&]() { found = kernel(buffer.data(), buffer.size(), positions.data()); }, repetitions);
+        std::cout << std::left << std::setw(12) << kind.second << std::right << std::setw(10)
+                  << megabytes / seconds << " MB/s  (" << found << " delimiters"
+                  << (found == expected ? "" : ", MISMATCH") << ")" << std::endl;
+    }
+    return 0;
+}
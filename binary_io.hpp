@@ -0,0 +1,117 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+class BinaryWriter
+{
+    /* Raw values in the native byte order, as in OrderCache. A vector or a string is its length (uint64)
+    followed by the elements
+    */
+    private:
+        std::ostream& stream;
+
+    public:
+        explicit BinaryWriter(std::ostream& stream): stream{stream} {}
+
+        template <typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "BinaryWriter: the value must be trivially copyable");
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        void write_vector(const std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "BinaryWriter: the values must be trivially copyable");
+            write<std::uint64_t>(values.size());
+            stream.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+        }
+
+        void write_string(std::string_view text)
+        {
+            write<std::uint64_t>(text.size());
+            stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+
+        bool good() const { return stream.good(); }
+};
+
+class BinaryReader
+{
+    /* Reads the values written by BinaryWriter. The first failure (end of the data, or a length longer than
+    the rest of the data) is sticky: every following read returns false and good() is false
+    */
+    private:
+        std::istream& stream;
+        std::uint64_t remaining; // bytes left in the data
+        bool failed = false;
+
+        bool take(std::uint64_t bytes)
+        {
+            if (failed || bytes > remaining)
+            {
+                failed = true;
+                return false;
+            }
+            remaining -= bytes;
+            return true;
+        }
+
+    public:
+        BinaryReader(std::istream& stream, std::uint64_t size): stream{stream}, remaining{size} {}
+
+        template <typename T>
+        bool read(T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "BinaryReader: the value must be trivially copyable");
+            if (!take(sizeof(T)) || !stream.read(reinterpret_cast<char*>(&value), sizeof(T)))
+            {
+                failed = true;
+            }
+            return !failed;
+        }
+
+        template <typename T>
+        bool read_vector(std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "BinaryReader: the values must be trivially copyable");
+            std::uint64_t size = 0;
+            if (!read(size) || size > remaining / sizeof(T) || !take(size * sizeof(T)))
+            {
+                failed = true;
+                return false;
+            }
+            values.resize(size);
+            if (!stream.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(size * sizeof(T))))
+            {
+                failed = true;
+            }
+            return !failed;
+        }
+
+        bool read_string(std::string& text)
+        {
+            std::uint64_t size = 0;
+            if (!read(size) || !take(size))
+            {
+                failed = true;
+                return false;
+            }
+            text.resize(size);
+            if (!stream.read(&text[0], static_cast<std::streamsize>(size)))
+            {
+                failed = true;
+            }
+            return !failed;
+        }
+
+        bool good() const { return !failed; }
+
+        std::uint64_t get_remaining() const { return remaining; }
+};
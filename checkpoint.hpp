@@ -0,0 +1,144 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <system_error>
+#include <cstdint>
+#include <cstring>
+#include "binary_io.hpp"
+#include "statistics.hpp"
+#include "symbol_dictionary.hpp"
+#include "order.hpp"
+
+class Checkpoint
+{
+    /* Binary checkpoint of the analytic state of the books of an order table (BasicOrderBook::save_state):
+    the accumulators with their median and quantile structures, the latest trade and quotes and the rolling windows.
+    A run over new data which starts from the checkpoint of the previous runs gives the same statistics
+    as a run over all the data, without reading the old data again. The retained orders are not part of it.
+
+    Layout (native byte order, BinaryWriter):
+        magic, version
+        settings                  Settings::encode, must be equal to the settings of the loading table
+        books_num (uint64)
+        per book: symbol name, BasicOrderBook::save_state
+    The symbols are stored by name and interned again on load, as in OrderCache.
+    */
+    public:
+        static constexpr char magic[8] = {'O', 'B', 'C', 'H', 'E', 'C', 'K', '\0'};
+        static constexpr std::uint32_t version = 2; // 2: truncation counts of the rolling windows
+
+        struct Settings
+        {
+            /* The options a checkpoint depends on, the storage mode is not one of them */
+            unsigned int metrics;
+            StatisticsMode statistics;
+            double relative_error;
+            int round_number_decimals;
+            std::size_t window_capacity;
+            std::vector<std::int64_t> windows;
+
+            std::string encode() const
+            {
+                std::ostringstream stream;
+                BinaryWriter out(stream);
+                out.write<std::uint32_t>(metrics);
+                out.write<std::uint32_t>(static_cast<std::uint32_t>(statistics));
+                // the error bound matters for the sketches only
+                out.write<double>(statistics == StatisticsMode::Approximate ? relative_error : 0.0);
+                out.write<std::int32_t>(round_number_decimals);
+                out.write<std::uint64_t>(window_capacity);
+                out.write_vector(windows);
+                out.write<std::uint32_t>(static_cast<std::uint32_t>(Order::price_scale));
+                return stream.str();
+            }
+        };
+
+        template <typename Book>
+        static bool write(const std::string& path, const std::vector<const Book*>& books, const Settings& settings)
+        {
+            /* The file is written next to the destination and renamed over it,
+            so an interrupted run leaves the previous checkpoint in place.
+            :returns false if the file cannot be written
+            */
+            std::string temporary = path + ".tmp";
+            {
+                std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+                if (!file)
+                {
+                    return false;
+                }
+                BinaryWriter out(file);
+                out.write(magic);
+                out.write(version);
+                out.write_string(settings.encode());
+                out.write<std::uint64_t>(books.size());
+                for (const Book* book : books)
+                {
+                    out.write_string(book->getSymbol());
+                    book->save_state(out);
+                }
+                if (!out.good())
+                {
+                    return false;
+                }
+            }
+            std::error_code error;
+            std::filesystem::rename(temporary, path, error);
+            return !error;
+        }
+
+        template <typename Load>
+        static bool read(const std::string& path, const Settings& settings, Load load, std::string& error)
+        {
+            /* :param load(symbol, reader) restores the state of the book of the symbol, returns false if it is invalid
+            :returns false with the reason in "error" if the file cannot be read or does not fit the settings
+            */
+            std::error_code size_error;
+            std::uint64_t size = std::filesystem::file_size(path, size_error);
+            std::ifstream file(path, std::ios::binary);
+            if (size_error || !file)
+            {
+                error = "cannot open the file";
+                return false;
+            }
+            BinaryReader in(file, size);
+            char header[sizeof(magic)] = {};
+            std::uint32_t saved_version = 0;
+            in.read(header);
+            in.read(saved_version);
+            if (!in.good() || std::memcmp(header, magic, sizeof(magic)) != 0 || saved_version != version)
+            {
+                error = "not a checkpoint of this version";
+                return false;
+            }
+            std::string saved_settings;
+            if (!in.read_string(saved_settings) || saved_settings != settings.encode())
+            {
+                error = "written with other metrics, statistics mode, error bound, windows or round number decimals";
+                return false;
+            }
+            std::uint64_t books_num = 0;
+            in.read(books_num);
+            SymbolDictionary& dictionary = SymbolDictionary::global();
+            std::string name;
+            for (std::uint64_t i = 0; i < books_num && in.good(); i++)
+            {
+                if (!in.read_string(name) || !load(dictionary.intern(name), in))
+                {
+                    error = in.good() ? "invalid state of the book " + name : "truncated or corrupted file";
+                    return false;
+                }
+            }
+            if (!in.good() || in.get_remaining() != 0)
+            {
+                error = "truncated or corrupted file";
+                return false;
+            }
+            return true;
+        }
+};
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include "spsc_queue.hpp"
+
+#ifdef ORDERBOOK_ZLIB
+#include <zlib.h>
+#endif
+
+enum class Compression
+{
+    None,
+    Gzip, // one or more concatenated gzip members, optionally followed by zero padding
+    Zip,  // the first entry of a zip archive, stored or deflated
+};
+
+class CompressedReader
+{
+    /* Decompresses a gzip file or the first entry of a zip archive on its own thread.
+    The inflated data is written into a fixed set of equally sized buffers which travel between the threads
+    through two SpscQueues: the filled ones to the consumer, the consumed ones back to the decompressor.
+    The number of buffers bounds the memory and how far the decompression runs ahead of the parsing,
+    nothing is written to disk. The buffers end at arbitrary positions, lines may span two buffers.
+    Requires zlib (ORDERBOOK_ZLIB), without it every file fails with an error.
+    */
+    public:
+        struct Chunk
+        {
+            const char* data;
+            std::size_t size;
+        };
+
+    private:
+        static constexpr std::size_t input_size = 1 << 18; // compressed bytes read from the file at once
+
+        std::string path;
+        std::size_t buffer_size;
+        std::vector<std::unique_ptr<char[]>> buffers;
+        SpscQueue<Chunk> filled;  // decompressor -> consumer
+        SpscQueue<char*> spare;   // consumer -> decompressor
+        std::atomic<bool> done{false};
+        std::atomic<bool> stopping{false};
+        std::string error;        // written by the decompressor before "done"
+        std::uint64_t inflated = 0;
+        std::thread worker;
+
+        static void wait(unsigned int& idle)
+        {
+            /* Back-off of a thread polling an empty queue, as ShardedOrderTable::consume */
+            if (++idle < 64)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        char* take_spare()
+        {
+            /* :returns an empty buffer or nullptr if the consumer has stopped */
+            unsigned int idle = 0;
+            while (!stopping.load(std::memory_order_relaxed))
+            {
+                char** buffer = spare.front();
+                if (buffer != nullptr)
+                {
+                    char* result = *buffer;
+                    spare.pop();
+                    return result;
+                }
+                wait(idle);
+            }
+            return nullptr;
+        }
+
+        void publish(char* buffer, std::size_t size)
+        {
+            filled.try_push(Chunk{buffer, size}); // never full, there are not more buffers than slots
+            inflated += size;
+        }
+
+        void run()
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+            {
+                error = "Failed to open file for reading: " + path;
+            }
+            else
+            {
+#ifdef ORDERBOOK_ZLIB
+                inflate_file(file);
+#else
+                error = "Compressed input requires zlib (ORDERBOOK_ZLIB): " + path;
+#endif
+            }
+            done.store(true, std::memory_order_release);
+        }
+
+#ifdef ORDERBOOK_ZLIB
+        bool skip_zip_header(std::ifstream& file, bool& deflated, std::uint64_t& stored_size)
+        {
+            /* Position the file at the data of the first entry, see the local file header of the zip format */
+            unsigned char header[30];
+            if (!file.read(reinterpret_cast<char*>(header), sizeof(header))
+                || std::memcmp(header, "PK\x03\x04", 4) != 0)
+            {
+                error = "Not a zip archive: " + path;
+                return false;
+            }
+            auto little16 = [&header](int offset) { return std::uint32_t(header[offset]) | std::uint32_t(header[offset + 1]) << 8; };
+            auto little32 = [&little16](int offset) { return little16(offset) | little16(offset + 2) << 16; };
+            std::uint32_t flags = little16(6);
+            std::uint32_t method = little16(8);
+            stored_size = little32(18);
+            if (method != 0 && method != 8)
+            {
+                error = "Unsupported zip compression method: " + path;
+                return false;
+            }
+            deflated = method == 8;
+            if (!deflated && (flags & 0x08) != 0)
+            {
+                error = "Stored zip entry of unknown size: " + path;
+                return false;
+            }
+            file.seekg(little16(26) + little16(28), std::ios::cur); // file name and extra field
+            return static_cast<bool>(file);
+        }
+
+        void inflate_file(std::ifstream& file)
+        {
+            char magic[2] = {};
+            file.read(magic, 2);
+            file.seekg(0);
+            bool zip = magic[0] == 'P' && magic[1] == 'K';
+            bool deflated = true;
+            std::uint64_t stored_size = 0;
+            if (zip && !skip_zip_header(file, deflated, stored_size))
+            {
+                return;
+            }
+            std::unique_ptr<char[]> input(new char[input_size]);
+            if (!deflated)
+            {
+                copy_stored(file, stored_size);
+                return;
+            }
+
+            z_stream stream{};
+            // a zip entry is a raw deflate stream, a gzip file has its own header and trailer
+            if (inflateInit2(&stream, zip ? -MAX_WBITS : MAX_WBITS + 16) != Z_OK)
+            {
+                error = "Failed to initialize zlib";
+                return;
+            }
+            char* buffer = take_spare();
+            std::size_t size = 0;
+            int status = Z_OK;
+            while (buffer != nullptr)
+            {
+                if (stream.avail_in == 0)
+                {
+                    file.read(input.get(), input_size);
+                    stream.next_in = reinterpret_cast<Bytef*>(input.get());
+                    stream.avail_in = static_cast<uInt>(file.gcount());
+                    if (stream.avail_in == 0)
+                    {
+                        if (status != Z_STREAM_END)
+                        {
+                            error = "Truncated compressed file: " + path;
+                        }
+                        break;
+                    }
+                }
+                if (status == Z_STREAM_END)
+                {
+                    if (zip)
+                    {
+                        break; // only the first entry is read
+                    }
+                    // zero padding after the last member is accepted as the end of the file, as gzip does
+                    while (stream.avail_in > 0 && *stream.next_in == 0)
+                    {
+                        stream.next_in++;
+                        stream.avail_in--;
+                    }
+                    if (stream.avail_in == 0)
+                    {
+                        continue;
+                    }
+                    inflateReset(&stream); // the next member of a concatenated gzip file
+                }
+                stream.next_out = reinterpret_cast<Bytef*>(buffer + size);
+                stream.avail_out = static_cast<uInt>(buffer_size - size);
+                status = inflate(&stream, Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+                {
+                    error = "Corrupted compressed file: " + path;
+                    break;
+                }
+                size = buffer_size - stream.avail_out;
+                if (size == buffer_size)
+                {
+                    publish(buffer, size);
+                    buffer = take_spare();
+                    size = 0;
+                }
+            }
+            if (buffer != nullptr && size > 0)
+            {
+                publish(buffer, size);
+            }
+            inflateEnd(&stream);
+        }
+
+        void copy_stored(std::ifstream& file, std::uint64_t remaining)
+        {
+            while (remaining > 0)
+            {
+                char* buffer = take_spare();
+                if (buffer == nullptr)
+                {
+                    return;
+                }
+                file.read(buffer, static_cast<std::streamsize>(std::min<std::uint64_t>(buffer_size, remaining)));
+                std::size_t size = static_cast<std::size_t>(file.gcount());
+                if (size == 0)
+                {
+                    error = "Truncated zip archive: " + path;
+                    return;
+                }
+                publish(buffer, size);
+                remaining -= size;
+            }
+        }
+#endif
+
+    public:
+        CompressedReader(const std::string& path, std::size_t buffer_size = 1 << 20, std::size_t buffers_num = 8):
+            path{path}, buffer_size{buffer_size}, filled(buffers_num), spare(buffers_num)
+        {
+            for (std::size_t i = 0; i < buffers_num; i++)
+            {
+                buffers.emplace_back(new char[buffer_size]);
+                spare.try_push(buffers.back().get());
+            }
+            worker = std::thread(&CompressedReader::run, this);
+        }
+
+        CompressedReader(const CompressedReader&) = delete;
+        CompressedReader& operator=(const CompressedReader&) = delete;
+
+        ~CompressedReader()
+        {
+            stopping.store(true, std::memory_order_relaxed);
+            if (worker.joinable())
+            {
+                worker.join();
+            }
+        }
+
+        static Compression detect(const std::string& path)
+        {
+            /* Recognizes the compressed files by their magic bytes */
+            unsigned char magic[4] = {};
+            std::ifstream file(path, std::ios::binary);
+            file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+            if (file.gcount() >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+            {
+                return Compression::Gzip;
+            }
+            if (file.gcount() == 4 && std::memcmp(magic, "PK\x03\x04", 4) == 0)
+            {
+                return Compression::Zip;
+            }
+            return Compression::None;
+        }
+
+        const Chunk* next()
+        {
+            /* Consumer side, waits for the next filled buffer.
+            :returns nullptr at the end of the data; the chunk is valid until recycle()
+            */
+            unsigned int idle = 0;
+            while (true)
+            {
+                const Chunk* chunk = filled.front();
+                if (chunk != nullptr)
+                {
+                    return chunk;
+                }
+                if (done.load(std::memory_order_acquire))
+                {
+                    return filled.front(); // the buffers published before "done" are visible now
+                }
+                wait(idle);
+            }
+        }
+
+        void recycle()
+        {
+            /* Consumer side, returns the buffer of the chunk returned by next() to the decompressor */
+            char* buffer = const_cast<char*>(filled.front()->data);
+            filled.pop();
+            spare.try_push(buffer);
+        }
+
+        bool failed() const { return done.load(std::memory_order_acquire) && !error.empty(); }
+
+        const std::string& getError() const { return error; }
+
+        std::uint64_t getInflatedBytes() const { return inflated; } // valid after next() returned nullptr
+};
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include "time_index.hpp"
+#include "summary_formatter.hpp"
+
+class CorrelationMatrix
+{
+    /* Symmetric matrix of the pairwise correlations, rows and columns in the order of "symbols".
+    A symbol whose mid price never moves on the grid has no defined correlation, its row is NaN.
+    */
+    private:
+        std::vector<SymbolId> symbols;
+        std::vector<double> values; // row-major, size() x size()
+
+    public:
+        CorrelationMatrix() = default;
+        CorrelationMatrix(const std::vector<SymbolId>& symbols, std::vector<double>&& values):
+            symbols{symbols}, values{std::move(values)} {}
+
+        std::size_t size() const { return symbols.size(); }
+
+        const std::vector<SymbolId>& get_symbols() const { return symbols; }
+
+        double at(std::size_t row, std::size_t column) const { return values[row * symbols.size() + column]; }
+
+        void save(const std::string& destination_file) const
+        {
+            /* CSV with the symbol names in the first row and column, the values in the shortest exact form */
+            const SymbolDictionary& dictionary = SymbolDictionary::global();
+            std::string text;
+            for (SymbolId symbol : symbols)
+            {
+                text.push_back(',');
+                text.append(dictionary.name(symbol));
+            }
+            text.push_back('\n');
+            for (std::size_t i = 0; i < symbols.size(); i++)
+            {
+                text.append(dictionary.name(symbols[i]));
+                for (std::size_t j = 0; j < symbols.size(); j++)
+                {
+                    text.push_back(',');
+                    SummaryFormatter::append_shortest(text, at(i, j));
+                }
+                text.push_back('\n');
+            }
+            SummaryFormatter::write(destination_file, text);
+        }
+};
+
+struct TimeGrid
+{
+    /* Grid times start + k * step for k in [0, points) */
+    std::int64_t start = 0; // nanoseconds
+    std::int64_t step = 0;  // nanoseconds
+    std::size_t points = 0;
+};
+
+class CorrelationEngine
+{
+    /* Co-movement of the mid prices of many symbols.
+    The asynchronous quote streams are aligned by an as-of join with a common time grid
+    (SymbolTimeIndex::sample_mids), the correlations are those of the log returns between the grid points.
+    A return is 0 where the mid price is not known at both ends, e.g. before the first quote of the symbol.
+    The returns of every symbol are standardized (zero mean, unit norm), so the correlation matrix is Z * Z^T.
+    The product is computed in tiles of tile x tile symbols, each tile pair streams "depth" grid points
+    at a time, so both panels stay in the cache while a 4 x 4 block of dot products is accumulated in registers.
+    Only the tiles on and above the diagonal are computed, they are distributed over the threads dynamically.
+    */
+    public:
+        static constexpr std::size_t tile = 32;   // symbols per side of a tile, a multiple of 4
+        static constexpr std::size_t depth = 256; // grid points per pass over a tile pair
+        static constexpr std::size_t max_grid_values = std::size_t(1) << 27; // symbols x grid points (1 GiB of returns)
+
+        static TimeGrid common_grid(const TimeIndex& index, const std::vector<SymbolId>& symbols, std::int64_t step)
+        {
+            /* Grid over the whole span of the quotes of the symbols.
+            A step which gives more than max_grid_values returns in total is rejected with an error
+            and the grid is empty, as for symbols without quotes
+            */
+            TimeGrid grid;
+            grid.step = step;
+            std::int64_t first = std::numeric_limits<std::int64_t>::max();
+            std::int64_t last = std::numeric_limits<std::int64_t>::min();
+            for (SymbolId symbol : symbols)
+            {
+                const SymbolTimeIndex* book = index.get_symbol(symbol);
+                if (book != nullptr && book->getQuotesNum() > 0)
+                {
+                    first = std::min(first, book->getFirstTime());
+                    last = std::max(last, book->getLastTime());
+                }
+            }
+            if (step > 0 && first <= last)
+            {
+                // the span is computed unsigned, so it cannot overflow for any pair of times
+                std::uint64_t span = static_cast<std::uint64_t>(last) - static_cast<std::uint64_t>(first);
+                std::uint64_t points = span / static_cast<std::uint64_t>(step) + 1;
+                std::uint64_t limit = max_grid_values / std::max<std::size_t>(1, padded(symbols.size()));
+                if (points > limit)
+                {
+                    std::cerr << "Correlation grid step of " << step << " ns gives " << points << " points for "
+                              << symbols.size() << " symbols, at most " << limit << " are allowed" << std::endl;
+                    return grid;
+                }
+                grid.start = first;
+                grid.points = static_cast<std::size_t>(points);
+            }
+            return grid;
+        }
+
+        static std::size_t padded(std::size_t rows)
+        {
+            return (rows + tile - 1) / tile * tile;
+        }
+
+        static std::vector<double> standardized_returns(const TimeIndex& index, const std::vector<SymbolId>& symbols,
+                                                        const TimeGrid& grid, std::vector<bool>& moving,
+                                                        unsigned int threads_num = std::thread::hardware_concurrency())
+        {
+            /* Rows of (grid.points - 1) standardized log returns, one per symbol, padded with zero rows
+            to a multiple of the tile. moving[i] is false if the mid price of the symbol never changes.
+            */
+            std::size_t length = grid.points > 0 ? grid.points - 1 : 0;
+            std::vector<double> rows(padded(symbols.size()) * length, 0.0);
+            moving.assign(symbols.size(), false);
+            std::vector<char> flags(symbols.size(), 0); // std::vector<bool> is not safe to write from several threads
+            for_each_parallel(symbols.size(), threads_num, [&](std::size_t i)
+            {
+                const SymbolTimeIndex* book = index.get_symbol(symbols[i]);
+                if (book == nullptr || length == 0)
+                {
+                    return;
+                }
+                std::vector<double> mids(grid.points);
+                book->sample_mids(grid.start, grid.step, grid.points, mids.data());
+                double* row = rows.data() + i * length;
+                double sum = 0.0;
+                for (std::size_t k = 0; k < length; k++)
+                {
+                    bool known = mids[k] > 0.0 && mids[k + 1] > 0.0; // false for NaN too
+                    row[k] = known ? std::log(mids[k + 1] / mids[k]) : 0.0;
+                    sum += row[k];
+                }
+                double mean = sum / static_cast<double>(length);
+                double squares = 0.0;
+                for (std::size_t k = 0; k < length; k++)
+                {
+                    row[k] -= mean;
+                    squares += row[k] * row[k];
+                }
+                if (squares > 0.0)
+                {
+                    double scale = 1.0 / std::sqrt(squares);
+                    for (std::size_t k = 0; k < length; k++)
+                    {
+                        row[k] *= scale;
+                    }
+                    flags[i] = 1;
+                }
+                else
+                {
+                    std::fill(row, row + length, 0.0);
+                }
+            });
+            for (std::size_t i = 0; i < symbols.size(); i++)
+            {
+                moving[i] = flags[i] != 0;
+            }
+            return rows;
+        }
+
+        static void multiply(const double* rows, std::size_t count, std::size_t length, double* result,
+                             unsigned int threads_num = std::thread::hardware_concurrency())
+        {
+            /* result (count x count, row-major) = rows * rows^T, count must be a multiple of the tile */
+            std::size_t tiles = count / tile;
+            std::vector<std::pair<std::size_t, std::size_t>> pairs;
+            for (std::size_t a = 0; a < tiles; a++)
+            {
+                for (std::size_t b = a; b < tiles; b++)
+                {
+                    pairs.emplace_back(a, b);
+                }
+            }
+            for_each_parallel(pairs.size(), threads_num, [&](std::size_t p)
+            {
+                multiply_tile(rows, length, pairs[p].first * tile, pairs[p].second * tile, result, count);
+            });
+        }
+
+        static void multiply_naive(const double* rows, std::size_t count, std::size_t length, double* result)
+        {
+            /* Reference product, one dot product per pair of rows */
+            for (std::size_t i = 0; i < count; i++)
+            {
+                for (std::size_t j = i; j < count; j++)
+                {
+                    double sum = 0.0;
+                    for (std::size_t k = 0; k < length; k++)
+                    {
+                        sum += rows[i * length + k] * rows[j * length + k];
+                    }
+                    result[i * count + j] = sum;
+                    result[j * count + i] = sum;
+                }
+            }
+        }
+
+        static CorrelationMatrix correlate(const TimeIndex& index, const std::vector<SymbolId>& symbols, std::int64_t step,
+                                           unsigned int threads_num = std::thread::hardware_concurrency())
+        {
+            /* Correlation matrix of the mid-price returns of the symbols on the grid of "step" nanoseconds */
+            TimeGrid grid = common_grid(index, symbols, step);
+            std::vector<bool> moving;
+            std::vector<double> rows = standardized_returns(index, symbols, grid, moving, threads_num);
+            std::size_t count = padded(symbols.size());
+            std::size_t length = grid.points > 0 ? grid.points - 1 : 0;
+            std::vector<double> product(count * count, 0.0);
+            multiply(rows.data(), count, length, product.data(), threads_num);
+
+            std::size_t size = symbols.size();
+            std::vector<double> values(size * size);
+            for (std::size_t i = 0; i < size; i++)
+            {
+                for (std::size_t j = 0; j < size; j++)
+                {
+                    double value = i == j ? 1.0 : std::max(-1.0, std::min(1.0, product[i * count + j]));
+                    values[i * size + j] = moving[i] && moving[j] ? value : std::numeric_limits<double>::quiet_NaN();
+                }
+            }
+            return CorrelationMatrix(symbols, std::move(values));
+        }
+
+    private:
+        template <typename Function>
+        static void for_each_parallel(std::size_t count, unsigned int threads_num, Function function)
+        {
+            /* function(i) for i in [0, count), the indices are taken from a shared counter */
+            std::atomic<std::size_t> next{0};
+            auto worker = [&]()
+            {
+                for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+                {
+                    function(i);
+                }
+            };
+            std::size_t threads = std::min<std::size_t>(std::max(1u, threads_num), count);
+            std::vector<std::thread> workers;
+            for (std::size_t t = 1; t < threads; t++)
+            {
+                workers.emplace_back(worker);
+            }
+            worker();
+            for (std::thread& thread : workers)
+            {
+                thread.join();
+            }
+        }
+
+        static void multiply_tile(const double* rows, std::size_t length, std::size_t first_row, std::size_t first_column,
+                                  double* result, std::size_t count)
+        {
+            double sums[tile][tile] = {};
+            for (std::size_t begin = 0; begin < length; begin += depth)
+            {
+                std::size_t end = std::min(length, begin + depth);
+                for (std::size_t i = 0; i < tile; i += 4)
+                {
+                    const double* a0 = rows + (first_row + i) * length;
+                    const double* a1 = a0 + length;
+                    const double* a2 = a1 + length;
+                    const double* a3 = a2 + length;
+                    // on the diagonal tile only the blocks on and above the diagonal are needed
+                    std::size_t j_begin = first_row == first_column ? i : 0;
+                    for (std::size_t j = j_begin; j < tile; j += 4)
+                    {
+                        const double* b0 = rows + (first_column + j) * length;
+                        const double* b1 = b0 + length;
+                        const double* b2 = b1 + length;
+                        const double* b3 = b2 + length;
+                        double s[4][4] = {};
+                        for (std::size_t k = begin; k < end; k++)
+                        {
+                            double x[4] = {a0[k], a1[k], a2[k], a3[k]};
+                            double y[4] = {b0[k], b1[k], b2[k], b3[k]};
+                            for (int u = 0; u < 4; u++)
+                            {
+                                for (int v = 0; v < 4; v++)
+                                {
+                                    s[u][v] += x[u] * y[v];
+                                }
+                            }
+                        }
+                        for (int u = 0; u < 4; u++)
+                        {
+                            for (int v = 0; v < 4; v++)
+                            {
+                                sums[i + u][j + v] += s[u][v];
+                            }
+                        }
+                    }
+                }
+            }
+            for (std::size_t i = 0; i < tile; i++)
+            {
+                for (std::size_t j = 0; j < tile; j++)
+                {
+                    if (first_row == first_column && j < i)
+                    {
+                        continue; // the lower half of the diagonal tile is the mirror of the upper one
+                    }
+                    result[(first_row + i) * count + first_column + j] = sums[i][j];
+                    result[(first_column + j) * count + first_row + i] = sums[i][j];
+                }
+            }
+        }
+};
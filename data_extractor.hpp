@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -5,74 +7,197 @@
 #include <vector>
 #include <chrono>
 #include <variant>
+#include <array>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <atomic>
+#include <filesystem>
 #include "order_book.hpp"
+#include "sharded_order_table.hpp"
+#include "mapped_file.hpp"
+#include "delimiter_scanner.hpp"
+#include "order_cache.hpp"
+#include "instrumentation.hpp"
+#include "snapshot_writer.hpp"
+#include "timestamp.hpp"
+#include "compressed_reader.hpp"
+#include "order_merger.hpp"
+#include "time_index.hpp"
 
-struct comma_delimiter : std::ctype<char> {
-    comma_delimiter() : std::ctype<char>(get_table()) {}
+enum class ReaderMode
+{
+    Stream,       // std::getline over std::ifstream
+    MemoryMapped, // the file is mapped and lines are tokenized in place
+    Parallel,     // the mapped file is split into chunks parsed on several threads
+    Cached,       // the binary cache of the file is loaded, it is written by the first (memory-mapped) parse
+    Compressed,   // gzip file or zip archive inflated on a separate thread (CompressedReader), requires zlib
+    Merged,       // several files read on their own threads and merged by the timestamp (OrderMerger)
+};
 
-    static std::ctype_base::mask const* get_table() {
-        static std::vector<std::ctype_base::mask> 
-            rc(std::ctype<char>::table_size, std::ctype_base::mask());
+struct FollowOptions
+{
+    /* Settings of DataParser::follow */
+    std::string snapshot_file;                            // OrderTable::save format, empty disables the snapshots
+    std::chrono::milliseconds snapshot_interval{1000};
+    std::chrono::milliseconds poll_interval{100};         // wait for new data at the end of a growing file
+    std::chrono::milliseconds idle_timeout{0};            // stop after no new data for this long, 0 waits for stop()
+};
 
-        rc[','] = std::ctype_base::space;
-        rc['\n'] = std::ctype_base::space;
-        rc['\r'] = std::ctype_base::space;
-        return &rc[0];
-    }
+struct InternCache
+{
+    /* Thread-local caches of the dictionaries and the dates used while parsing */
+    SymbolCache symbols;
+    SymbolCache conditions;
+    DateCache dates;
+    InternCache(): symbols(SymbolDictionary::global()), conditions(SymbolDictionary::conditions()) {}
 };
 
-class DataParser
+template <unsigned int Set>
+class BasicDataParser
 { 
+    /* Reads the input file into an order table computing the statistics of the metric set "Set" (Metrics) */
+    public:
+        using Table = BasicOrderTable<Set>;
+        using ShardedTable = BasicShardedOrderTable<Set>;
+
     private:
         std::string file_path;
+        std::string cache_path;
+        std::vector<std::string> file_paths; // ReaderMode::Merged, file_path is the first one
         int orders_num_limit;
-        OrderTable orders_table;
-        void process_order_details(const std::string& symbol,
-                                    double bid_p,
-                                    double ask_p,
-                                    double trade_p,
-                                    unsigned int bid_v,
-                                    unsigned int ask_v,
-                                    unsigned int trade_v,
-                                    short int update_type,
-                                    const std::string& date,
-                                    double seconds,
-                                    const std::string& condition)
-        {
-            UpdateType type = process_type(update_type);
-            auto date_details = parse_date(date);
-            auto time_point = createTimePoint(date_details[0], date_details[1], date_details[2], seconds);
-            Order order(symbol, bid_p, ask_p, trade_p, bid_v, ask_v, trade_v, condition, type, date, time_point);
-            orders_table.processOrder(order);
+        Table orders_table;
+        InternCache intern_cache;
+        std::unique_ptr<ShardedTable> sharded_table; // replaces orders_table if shards are enabled
+        static constexpr std::size_t fields_num = 16; // number of columns in the input line
+        static constexpr std::size_t block_size = 1 << 18; // bytes scanned for delimiters at once
+        std::size_t chunk_size = 1 << 22; // bytes parsed by a worker thread at once (parallel mode)
+        unsigned int threads_num = std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<bool> stop_requested{false}; // ends follow()
+        static Order process_order_details(SymbolId symbol,
+                                    std::int64_t bid_p,
+                                    std::int64_t ask_p,
+                                    std::int64_t trade_p,
+                                    std::uint32_t bid_v,
+                                    std::uint32_t ask_v,
+                                    std::uint32_t trade_v,
+                                    UpdateType type,
+                                    std::uint32_t date,
+                                    std::int64_t time_of_day,
+                                    ConditionId condition,
+                                    DateCache& dates)
+        {
+            /* :param time_of_day in nanoseconds after midnight
+            The timestamp is the cached midnight of the date plus the time of day, no allocation per row
+            */
+            std::int64_t time = dates.timestamp(date, time_of_day);
+            return Order(symbol, bid_p, ask_p, trade_p, bid_v, ask_v, trade_v, condition, type, date, time);
+        }
+        void dispatch(const Order& order)
+        {
+            if (sharded_table)
+            {
+                sharded_table->processOrder(order);
+            }
+            else
+            {
+                orders_table.processOrder(order);
+            }
+        }
+        void finish_processing()
+        {
+            if (sharded_table)
+            {
+                sharded_table->finish(); // wait for the shard workers to analyse all queued orders
+            }
         }
     public:
-        DataParser(const std::string& path): file_path{path}, orders_table()
+        BasicDataParser(const std::string& path): file_path{path}, cache_path{path + ".cache"}, orders_table()
         {
             std::cout<<"Data Parser has been initiated"<<std::endl;
         }
-        DataParser(const std::string& path, int data_num): file_path{path}, orders_num_limit{data_num} {}
-        ~DataParser() {}
-        void start()
+        BasicDataParser(const std::string& path, int data_num): file_path{path}, cache_path{path + ".cache"}, orders_num_limit{data_num} {}
+        BasicDataParser(const std::string& path, int data_num, const BookOptions& options): file_path{path},
+                                                                                         cache_path{path + ".cache"},
+                                                                                         orders_num_limit{data_num},
+                                                                                         orders_table(options) {}
+        BasicDataParser(const std::vector<std::string>& paths, int data_num, const BookOptions& options = BookOptions()):
+            BasicDataParser(paths.empty() ? std::string() : paths.front(), data_num, options)
+        {
+            /* The files are read together by start(ReaderMode::Merged), e.g. one file per exchange or day */
+            file_paths = paths;
+        }
+        ~BasicDataParser() {}
+        void start(ReaderMode mode = ReaderMode::Stream)
         {
+            if (mode == ReaderMode::MemoryMapped)
+            {
+                read_mapped(0);
+                return;
+            }
+            if (mode == ReaderMode::Parallel)
+            {
+                read_parallel();
+                return;
+            }
+            if (mode == ReaderMode::Cached)
+            {
+                read_cached();
+                return;
+            }
+            if (mode == ReaderMode::Compressed)
+            {
+                read_compressed(0);
+                return;
+            }
+            if (mode == ReaderMode::Merged)
+            {
+                read_merged(0);
+                return;
+            }
             std::cout<<"Started reading file"<<std::endl;
             std::ifstream classFile(file_path);
             std::string line;
 
-            while(std::getline(classFile, line, '\n'))
+            while(read_line(classFile, line))
             {
                 parse_line(line);
             }
 
+            finish_processing();
             std::cout<<"Reading file has been finished"<<std::endl;
         }
-        void test_start()
+        void test_start(ReaderMode mode = ReaderMode::Stream)
         {
+            if (mode == ReaderMode::Compressed)
+            {
+                read_compressed(orders_num_limit == 0 ? 1 : orders_num_limit);
+                return;
+            }
+            if (mode == ReaderMode::Merged)
+            {
+                read_merged(orders_num_limit == 0 ? 1 : orders_num_limit);
+                return;
+            }
+            if (mode == ReaderMode::MemoryMapped || mode == ReaderMode::Parallel || mode == ReaderMode::Cached)
+            {
+                // the lines are counted in file order, the limited read is done serially
+                read_mapped(orders_num_limit == 0 ? 1 : orders_num_limit);
+                return;
+            }
             std::cout<<"Started reading file"<<std::endl;
             std::ifstream classFile(file_path);
             std::string line;
             int counter = 0;
 
-            while(std::getline(classFile, line, '\n'))
+            while(read_line(classFile, line))
             {
                 parse_line(line);
                 counter++;
@@ -82,52 +207,733 @@ class DataParser
                 }
             }
 
+            finish_processing();
             std::cout<<"Reading file has been finished"<<std::endl;
         }
-        void parse_line(const std::string& line)
+        void follow(const FollowOptions& options = FollowOptions())
+        {
+            /* Live ingest: read the lines of a growing file (or of stdin if the path is "-") as they are appended
+            and pass them to the order table one by one. At the end of a file the reader waits for more data,
+            an incomplete last line is kept until its newline arrives. Stdin is read until its end.
+            The reading stops at the end of stdin, after options.idle_timeout without new data or on stop().
+            The snapshots of the table are written off the ingest thread by SnapshotWriter, the final one at the end.
+            The orders are analysed on the reading thread, the sharded table is not supported here.
+            */
+            if (sharded_table)
+            {
+                std::cerr<<"Follow mode does not support the sharded order table"<<std::endl;
+                return;
+            }
+            bool from_stdin = file_path == "-";
+            std::ifstream file;
+            if (!from_stdin)
+            {
+                file.open(file_path);
+                if (!file.is_open())
+                {
+                    std::cerr<<"Failed to open file for reading: "<<file_path<<std::endl;
+                    return;
+                }
+            }
+            std::istream& input = from_stdin ? std::cin : file;
+            std::unique_ptr<SnapshotWriter> snapshots;
+            if (!options.snapshot_file.empty())
+            {
+                snapshots.reset(new SnapshotWriter(options.snapshot_file, options.snapshot_interval, &Table::save_summaries));
+            }
+
+            std::cout<<"Started following file"<<std::endl;
+            stop_requested.store(false);
+            std::string line;
+            std::string partial; // beginning of a line which has not been completed yet
+            auto last_data = std::chrono::steady_clock::now();
+            while (!stop_requested.load(std::memory_order_relaxed))
+            {
+                if (read_line(input, line) && !input.eof())
+                {
+                    if (partial.empty())
+                    {
+                        parse_line(line);
+                    }
+                    else
+                    {
+                        partial += line;
+                        parse_line(partial);
+                        partial.clear();
+                    }
+                    if (snapshots && snapshots->due())
+                    {
+                        snapshots->publish(orders_table.get_summaries());
+                    }
+                    last_data = std::chrono::steady_clock::now();
+                    continue;
+                }
+                // end of the available data
+                partial += line;
+                if (from_stdin)
+                {
+                    break;
+                }
+                if (!line.empty())
+                {
+                    last_data = std::chrono::steady_clock::now();
+                }
+                if (options.idle_timeout.count() > 0 && std::chrono::steady_clock::now() - last_data >= options.idle_timeout)
+                {
+                    break;
+                }
+                input.clear();
+                std::this_thread::sleep_for(options.poll_interval);
+            }
+            if (!partial.empty() && from_stdin)
+            {
+                parse_line(partial); // the last line of stdin without the trailing newline
+            }
+            if (snapshots)
+            {
+                snapshots->publish(orders_table.get_summaries());
+                snapshots->stop();
+            }
+            std::cout<<"Following file has been finished"<<std::endl;
+        }
+        void stop()
+        {
+            /* Ends follow(), may be called from any thread */
+            stop_requested.store(true);
+        }
+        static bool read_line(std::istream& stream, std::string& line)
+        {
+            ORDERBOOK_STAGE(Stage::Read);
+            return static_cast<bool>(std::getline(stream, line, '\n'));
+        }
+        void read_mapped(int limit)
+        {
+            /* The file is memory-mapped and parsed in blocks of complete lines: the delimiters of a whole block
+            are located by DelimiterScanner and the fields are passed to the parser as views into the mapping,
+            so no line is copied and no stream is constructed.
+            :param limit is the maximum number of lines to read, 0 means the whole file
+            */
+            std::cout<<"Started reading file"<<std::endl;
+            MappedFile file(file_path);
+            if (!file.is_open())
+            {
+                std::cerr<<"Failed to open file for reading: "<<file_path<<std::endl;
+                return;
+            }
+            std::vector<std::uint32_t> positions(block_size);
+            int counter = 0;
+            parse_range(file.view(), positions, counter, limit,
+                        [this](const std::array<std::string_view, fields_num>& fields, std::size_t count)
+                        {
+                            parse_fields(fields, count);
+                        });
+
+            finish_processing();
+            std::cout<<"Reading file has been finished"<<std::endl;
+        }
+        void read_compressed(int limit)
+        {
+            /* The file is inflated by CompressedReader on its own thread while this thread parses the buffers
+            it has already produced, as in read_mapped.
+            :param limit is the maximum number of lines to read, 0 means the whole file
+            */
+            std::cout<<"Started reading file"<<std::endl;
+            CompressedReader reader(file_path);
+            std::vector<std::uint32_t> positions(block_size);
+            int counter = 0;
+            parse_compressed(reader, positions, counter, limit,
+                             [this](const std::array<std::string_view, fields_num>& fields, std::size_t count)
+                             {
+                                 parse_fields(fields, count);
+                             });
+            if (reader.failed())
+            {
+                std::cerr<<reader.getError()<<std::endl;
+            }
+
+            finish_processing();
+            std::cout<<"Reading file has been finished"<<std::endl;
+        }
+        template <typename Sink>
+        static void parse_compressed(CompressedReader& reader, std::vector<std::uint32_t>& positions,
+                                     int& counter, int limit, Sink&& sink)
+        {
+            /* Parse the buffers of the reader as they are inflated. The incomplete last line of a buffer is copied
+            to "carry" and completed by the beginning of the next buffer.
+            */
+            std::string carry; // beginning of a line continued in the next buffer
+            while (const CompressedReader::Chunk* chunk = reader.next())
+            {
+                std::string_view data(chunk->data, chunk->size);
+                std::size_t first_newline = carry.empty() ? 0 : data.find('\n');
+                if (first_newline == std::string_view::npos)
+                {
+                    carry.append(data); // the buffer is a part of a single long line
+                    reader.recycle();
+                    continue;
+                }
+                if (!carry.empty())
+                {
+                    carry.append(data.substr(0, first_newline + 1));
+                    parse_range(carry, positions, counter, limit, sink);
+                    carry.clear();
+                    data.remove_prefix(first_newline + 1);
+                }
+                std::size_t last_newline = data.rfind('\n');
+                std::size_t complete = last_newline == std::string_view::npos ? 0 : last_newline + 1;
+                if (limit == 0 || counter < limit)
+                {
+                    parse_range(data.substr(0, complete), positions, counter, limit, sink);
+                }
+                carry.append(data.substr(complete));
+                reader.recycle();
+                if (limit != 0 && counter >= limit)
+                {
+                    carry.clear();
+                    break;
+                }
+            }
+            if (!carry.empty())
+            {
+                parse_range(carry, positions, counter, limit, sink); // the last line without the trailing newline
+            }
+        }
+        void read_merged(int limit)
+        {
+            /* Every file of file_paths is read and parsed on its own thread (plain text mapped as in read_mapped,
+            gzip or zip through CompressedReader), the orders of the files are merged by the timestamp
+            (OrderMerger) on this thread and passed to the order table. The books receive the orders of all files
+            in time order, so the gaps spanning the boundary between two files are counted as in a single file.
+            :param limit is the maximum number of orders of the merged stream, 0 means all of them.
+            The merged stream has no line order, so unlike the other readers the limit counts the orders:
+            a file is read until "limit" of its rows have been accepted, the rejected rows are not counted,
+            so every file contributes its first "limit" orders, which is enough for the first "limit" merged orders
+            */
+            if (file_paths.empty())
+            {
+                file_paths.push_back(file_path);
+            }
+            std::cout<<"Started reading "<<file_paths.size()<<" files"<<std::endl;
+            const std::vector<std::string>& paths = file_paths;
+            OrderMerger merger(paths.size(), [&paths, limit](std::size_t index, OrderMerger::Output& output)
+            {
+                std::vector<std::uint32_t> positions(block_size);
+                InternCache symbols; // each reader interns the symbols through its own cache
+                int counter = 0;
+                auto sink = [&output, &symbols, &counter](const std::array<std::string_view, fields_num>& fields,
+                                                           std::size_t count)
+                            {
+                                std::optional<Order> order = parse_order(fields, count, symbols);
+                                if (order)
+                                {
+                                    output.push(*order);
+                                }
+                                else
+                                {
+                                    counter--; // parse_block counts every line, a rejected one is taken back
+                                }
+                            };
+                if (CompressedReader::detect(paths[index]) != Compression::None)
+                {
+                    CompressedReader reader(paths[index]);
+                    parse_compressed(reader, positions, counter, limit, sink);
+                    if (reader.failed())
+                    {
+                        std::cerr<<reader.getError()<<std::endl;
+                    }
+                    return;
+                }
+                MappedFile file(paths[index]);
+                if (!file.is_open())
+                {
+                    std::cerr<<"Failed to open file for reading: "<<paths[index]<<std::endl;
+                    return;
+                }
+                parse_range(file.view(), positions, counter, limit, sink);
+            });
+            merger.merge([this](const Order& order) { dispatch(order); }, static_cast<std::size_t>(limit));
+
+            finish_processing();
+            std::cout<<"Reading file has been finished"<<std::endl;
+        }
+        void read_parallel()
+        {
+            /* The mapped file is split into newline-aligned chunks which are parsed into orders by threads_num workers.
+            The orders of each chunk are passed to the order table by the calling thread strictly in the chunk order,
+            so every order book receives its orders in the original file order and the statistics are identical
+            to the serial run. At most "window" chunks are parsed ahead of the table to bound the memory.
+            The order buffers of the consumed chunks are returned to a pool and reused by the workers,
+            so the buffers are allocated for the first chunks only.
+            */
+            std::cout<<"Started reading file"<<std::endl;
+            MappedFile file(file_path);
+            if (!file.is_open())
+            {
+                std::cerr<<"Failed to open file for reading: "<<file_path<<std::endl;
+                return;
+            }
+            std::vector<std::string_view> chunks = split_chunks(file.view(), chunk_size);
+            std::vector<std::vector<Order>> parsed(chunks.size());
+            std::vector<bool> ready(chunks.size(), false);
+            const std::size_t window = 4 * static_cast<std::size_t>(threads_num);
+            std::size_t next = 0;     // next chunk to be taken by a worker
+            std::size_t consumed = 0; // chunks already passed to the table
+            std::vector<std::vector<Order>> spare; // cleared buffers of the consumed chunks
+            std::mutex mutex;
+            std::condition_variable chunk_ready;
+            std::condition_variable chunk_consumed;
+
+            auto worker = [&]()
+            {
+                std::vector<std::uint32_t> positions(block_size);
+                InternCache symbols; // each worker interns the symbols through its own cache
+                while (true)
+                {
+                    std::size_t index;
+                    std::vector<Order> orders;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        chunk_consumed.wait(lock, [&]() { return next >= chunks.size() || next < consumed + window; });
+                        if (next >= chunks.size())
+                        {
+                            return;
+                        }
+                        index = next++;
+                        if (!spare.empty())
+                        {
+                            orders.swap(spare.back());
+                            spare.pop_back();
+                        }
+                    }
+                    int counter = 0;
+                    parse_range(chunks[index], positions, counter, 0,
+                                [&orders, &symbols](const std::array<std::string_view, fields_num>& fields, std::size_t count)
+                                {
+                                    std::optional<Order> order = parse_order(fields, count, symbols);
+                                    if (order)
+                                    {
+                                        orders.push_back(*order);
+                                    }
+                                });
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        parsed[index].swap(orders);
+                        ready[index] = true;
+                    }
+                    chunk_ready.notify_all();
+                }
+            };
+
+            std::vector<std::thread> workers;
+            for (unsigned int i = 0; i < threads_num; i++)
+            {
+                workers.emplace_back(worker);
+            }
+            for (std::size_t index = 0; index < chunks.size(); index++)
+            {
+                std::vector<Order> orders;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    chunk_ready.wait(lock, [&]() { return ready[index]; });
+                    orders.swap(parsed[index]);
+                }
+                for (const Order& order : orders)
+                {
+                    dispatch(order);
+                }
+                orders.clear();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    consumed++;
+                    spare.push_back(std::move(orders));
+                }
+                chunk_consumed.notify_all();
+            }
+            for (std::thread& thread : workers)
+            {
+                thread.join();
+            }
+
+            finish_processing();
+            std::cout<<"Reading file has been finished"<<std::endl;
+        }
+        void read_cached()
+        {
+            /* Load the orders from the binary cache of the file (OrderCache) if it is up to date.
+            Otherwise the file is parsed as in read_mapped and the cache is written for the next runs.
+            The cache keeps the orders grouped by symbol, so the books receive their own orders in the file order
+            and the statistics are identical to the parse of the text file.
+            */
+            std::uint64_t source_size;
+            std::int64_t source_time;
+            if (!source_info(source_size, source_time))
+            {
+                std::cerr<<"Failed to open file for reading: "<<file_path<<std::endl;
+                return;
+            }
+            {
+                OrderCacheReader cache(cache_path);
+                if (cache.matches(source_size, source_time))
+                {
+                    std::cout<<"Started reading cache"<<std::endl;
+                    cache.load([this](const Order& order) { dispatch(order); });
+                    finish_processing();
+                    std::cout<<"Reading file has been finished"<<std::endl;
+                    return;
+                }
+            }
+
+            std::cout<<"Started reading file"<<std::endl;
+            MappedFile file(file_path);
+            if (!file.is_open())
+            {
+                std::cerr<<"Failed to open file for reading: "<<file_path<<std::endl;
+                return;
+            }
+            std::vector<std::uint32_t> positions(block_size);
+            std::vector<OrderColumns> books; // indexed by SymbolId
+            int counter = 0;
+            parse_range(file.view(), positions, counter, 0,
+                        [this, &books](const std::array<std::string_view, fields_num>& fields, std::size_t count)
+                        {
+                            std::optional<Order> order = parse_order(fields, count, intern_cache);
+                            if (order)
+                            {
+                                if (books.size() <= order->getSymbolId())
+                                {
+                                    books.resize(order->getSymbolId() + 1);
+                                }
+                                books[order->getSymbolId()].push_back(*order);
+                                dispatch(*order);
+                            }
+                        });
+
+            finish_processing();
+            if (!OrderCache::write(cache_path, books, source_size, source_time))
+            {
+                std::cerr<<"Failed to write the cache: "<<cache_path<<std::endl;
+            }
+            std::cout<<"Reading file has been finished"<<std::endl;
+        }
+        bool source_info(std::uint64_t& size, std::int64_t& time) const
+        {
+            /* Size and modification time of the input file, used to detect a stale cache */
+            std::error_code error;
+            size = std::filesystem::file_size(file_path, error);
+            if (error)
+            {
+                return false;
+            }
+            time = static_cast<std::int64_t>(std::filesystem::last_write_time(file_path, error).time_since_epoch().count());
+            return !error;
+        }
+        void set_cache_path(const std::string& path)
+        {
+            /* Location of the binary cache used by ReaderMode::Cached, "<input>.cache" by default */
+            cache_path = path;
+        }
+        const std::string& get_cache_path() const
+        {
+            return cache_path;
+        }
+        static std::vector<std::string_view> split_chunks(std::string_view content, std::size_t size)
+        {
+            /* Split the content into ranges of about "size" bytes, each range ends after a newline
+            (except the last one if the file does not end with a newline)
+            */
+            std::vector<std::string_view> chunks;
+            std::size_t position = 0;
+            while (position < content.size())
+            {
+                std::size_t end = position + size;
+                if (end >= content.size())
+                {
+                    end = content.size();
+                }
+                else
+                {
+                    std::size_t newline = content.find('\n', end);
+                    end = newline == std::string_view::npos ? content.size() : newline + 1;
+                }
+                chunks.push_back(content.substr(position, end - position));
+                position = end;
+            }
+            return chunks;
+        }
+        void set_threads_num(unsigned int threads)
+        {
+            threads_num = std::max(1u, threads);
+        }
+        void set_chunk_size(std::size_t size)
+        {
+            /* Bytes of a chunk of ReaderMode::Parallel, the chunks are extended to the end of their last line */
+            chunk_size = std::max<std::size_t>(1, size);
+        }
+        template <typename Sink>
+        static void parse_range(std::string_view content, std::vector<std::uint32_t>& positions,
+                                int& counter, int limit, Sink&& sink)
+        {
+            /* Split the content into blocks of complete lines of about block_size bytes and parse them one by one */
+            std::size_t position = 0;
+            while (position < content.size())
+            {
+                // the block ends after the last complete line within block_size bytes
+                std::size_t end = std::min(position + block_size, content.size());
+                if (end < content.size())
+                {
+                    std::size_t last_newline = content.rfind('\n', end - 1);
+                    if (last_newline == std::string_view::npos || last_newline < position)
+                    {
+                        // the line is longer than the block, extend the block up to its end
+                        last_newline = content.find('\n', end);
+                        if (last_newline == std::string_view::npos)
+                        {
+                            last_newline = content.size() - 1;
+                        }
+                    }
+                    end = last_newline + 1;
+                }
+                std::string_view block = content.substr(position, end - position);
+                if (positions.size() < block.size())
+                {
+                    positions.resize(block.size());
+                }
+                if (parse_block(block, positions.data(), counter, limit, sink))
+                {
+                    break;
+                }
+                position = end;
+            }
+        }
+        template <typename Sink>
+        static bool parse_block(std::string_view block, std::uint32_t* positions, int& counter, int limit, Sink& sink)
+        {
+            /* Parse all lines of the block using the delimiter positions found by the vectorized scanner.
+            The block contains complete lines only (the last line of the file may miss the newline).
+            :returns true if the limit of the lines has been reached
+            */
+            std::size_t delimiters;
+            {
+                ORDERBOOK_STAGE(Stage::Scan);
+                delimiters = DelimiterScanner::scan(block.data(), block.size(), positions);
+            }
+            std::array<std::string_view, fields_num> fields;
+            std::size_t count = 0;
+            std::size_t field_begin = 0;
+            std::size_t line_begin = 0;
+
+            for (std::size_t k = 0; k < delimiters; k++)
+            {
+                std::size_t p = positions[k];
+                if (p > field_begin && count < fields_num)
+                {
+                    fields[count++] = block.substr(field_begin, p - field_begin);
+                }
+                field_begin = p + 1;
+                if (block[p] == '\n')
+                {
+                    sink(fields, count);
+                    count = 0;
+                    line_begin = p + 1;
+                    counter++;
+                    if (counter == limit)
+                    {
+                        return true;
+                    }
+                }
+            }
+            if (line_begin < block.size())
+            {
+                // last line of the file without the trailing newline
+                if (field_begin < block.size() && count < fields_num)
+                {
+                    fields[count++] = block.substr(field_begin);
+                }
+                sink(fields, count);
+                counter++;
+            }
+            return counter == limit;
+        }
+        static std::size_t split_line(std::string_view line, std::array<std::string_view, fields_num>& fields)
+        {
+            /* Split the line into the views of its fields.
+            Commas and carriage returns are delimiters and consecutive delimiters are treated as one,
+            so an empty column is skipped (e.g. an empty condition code is followed by "@1").
+            :returns the number of fields found, at most fields_num
+            */
+            std::size_t count = 0;
+            std::size_t begin = 0;
+            for (std::size_t i = 0; i <= line.size() && count < fields_num; i++)
+            {
+                if (i == line.size() || line[i] == ',' || line[i] == '\r')
+                {
+                    if (i > begin)
+                    {
+                        fields[count++] = line.substr(begin, i - begin);
+                    }
+                    begin = i + 1;
+                }
+            }
+            return count;
+        }
+        static bool parse_price(std::string_view field, std::int64_t& ticks)
+        {
+            /* Convert a decimal price (e.g. "158.1") directly into ticks of 1 / Order::price_scale */
+            return parse_fixed(field, Order::price_scale, ticks);
+        }
+        static bool parse_seconds(std::string_view field, std::int64_t& nanoseconds)
+        {
+            /* Convert the seconds after midnight (e.g. "28800.123") into nanoseconds */
+            return parse_fixed(field, Timestamp::nanoseconds_per_second, nanoseconds);
+        }
+        static bool parse_fixed(std::string_view field, std::int64_t units_scale, std::int64_t& value)
+        {
+            /* Convert a decimal number directly into an integer number of 1 / units_scale (a power of ten)
+            without going through a double, the digits beyond the resolution are rounded half up
+            */
+            const char* p = field.data();
+            const char* end = p + field.size();
+            bool negative = p != end && *p == '-';
+            if (negative)
+            {
+                p++;
+            }
+            std::int64_t units = 0;
+            if (p == end || *p != '.') // ".5" has no integer part
+            {
+                auto result = std::from_chars(p, end, units);
+                if (result.ec != std::errc() || units < 0)
+                {
+                    return false;
+                }
+                p = result.ptr;
+            }
+            std::int64_t fraction = 0;
+            std::int64_t scale = units_scale;
+            if (p != end && *p == '.')
+            {
+                p++;
+                for (; p != end && *p >= '0' && *p <= '9'; p++)
+                {
+                    if (scale > 1)
+                    {
+                        scale /= 10;
+                        fraction += (*p - '0') * scale;
+                    }
+                    else if (scale == 1)
+                    {
+                        fraction += *p >= '5' ? 1 : 0; // first digit beyond the resolution
+                        scale = 0;
+                    }
+                }
+            }
+            if (p != end)
+            {
+                return false;
+            }
+            value = units * units_scale + fraction;
+            if (negative)
+            {
+                value = -value;
+            }
+            return true;
+        }
+        template <typename T>
+        static bool parse_number(std::string_view field, T& value)
+        {
+            const char* end = field.data() + field.size();
+            auto result = std::from_chars(field.data(), end, value);
+            return result.ec == std::errc() && result.ptr == end;
+        }
+        void parse_line(std::string_view line)
         {
             /* Each data entity has certain position on the line according to the commas
             The function assign the variables with the data entity value according to its position.
-            For skipping unnecessory data entity, "skip" variable has been allocated.
-            */
-            std::istringstream iss(line);
-            iss.imbue(std::locale(std::locale(), new comma_delimiter)); // append the delimiter of 'iss' with comma (overwriting the previous object)
-            
-            std::string skip; // overwrite the unnessory order details
-            std::string symbol;
-            double bid_price;
-            double ask_price;
-            double trade_price;
-            unsigned int bid_volume;
-            unsigned int ask_volume;
-            unsigned int trade_volume;
+            The fields are views into the line and the numbers are converted in place (parse_fields),
+            unnecessary data entities are not converted at all.
+            */
+            std::array<std::string_view, fields_num> fields;
+            std::size_t count = split_line(line, fields);
+            parse_fields(fields, count);
+        }
+        void parse_fields(const std::array<std::string_view, fields_num>& fields, std::size_t count)
+        {
+            std::optional<Order> order = parse_order(fields, count, intern_cache);
+            if (order)
+            {
+                dispatch(*order);
+            }
+        }
+        static std::optional<Order> parse_order(const std::array<std::string_view, fields_num>& fields, std::size_t count,
+                                                InternCache& symbols)
+        {
+            /* Convert the fields of a line into the order
+            :returns empty optional if the line is malformed or the order is not valid
+            */
+            if (count <= 14)
+            {
+                ORDERBOOK_COUNT_MALFORMED();
+                return std::nullopt; // the condition codes are missing, the order cannot be valid
+            }
+
+            std::int64_t bid_price;   // ticks
+            std::int64_t ask_price;   // ticks
+            std::int64_t trade_price; // ticks
+            std::uint32_t bid_volume;
+            std::uint32_t ask_volume;
+            std::uint32_t trade_volume;
             short int update_type; // can be withing range of [1, 3]
-            std::string date;
-            double seconds;
-            std::string condition_codes;
+            std::uint32_t date;
+            std::int64_t time_of_day; // nanoseconds after midnight
+            std::optional<UpdateType> type;
+            std::string_view condition_codes = fields[14];
 
             // assign the value of variables according to the position of data entity in the line
-            iss >> symbol >> skip >> bid_price >> ask_price >> trade_price >> bid_volume >> ask_volume 
-            >> trade_volume >> update_type >> skip >> date >> seconds >> skip >> skip
-            >> condition_codes;
+            bool parsed;
+            {
+                ORDERBOOK_STAGE(Stage::Parse);
+                parsed = parse_price(fields[2], bid_price) && parse_price(fields[3], ask_price)
+                      && parse_price(fields[4], trade_price) && parse_number(fields[5], bid_volume)
+                      && parse_number(fields[6], ask_volume) && parse_number(fields[7], trade_volume)
+                      && parse_number(fields[8], update_type) && parse_number(fields[10], date)
+                      && parse_seconds(fields[11], time_of_day);
+            }
+            bool valid;
+            {
+                ORDERBOOK_STAGE(Stage::Validate);
+                if (parsed)
+                {
+                    type = process_type(update_type); // e.g. type 8 in Sample_data.txt is not an order book update
+                }
+                valid = type && valid_order(condition_codes);
+            }
 
-            if (valid_order(condition_codes))
+            if (valid)
             {
-                condition_codes == "@1" ? condition_codes = "": condition_codes=condition_codes;
-                process_order_details(symbol,
+                ORDERBOOK_STAGE(Stage::Build);
+                if (condition_codes == "@1")
+                {
+                    condition_codes = std::string_view();
+                }
+                Order order = process_order_details(symbols.symbols.intern(fields[0]),
                                     bid_price,
                                     ask_price,
                                     trade_price,
                                     bid_volume,
                                     ask_volume,
                                     trade_volume,
-                                    update_type,
+                                    *type,
                                     date,
-                                    seconds,
-                                    condition_codes);
+                                    time_of_day,
+                                    static_cast<ConditionId>(symbols.conditions.intern(condition_codes)),
+                                    symbols.dates);
+                ORDERBOOK_COUNT_ROW(order.getSymbolId(), true);
+                return order;
             }
+            ORDERBOOK_COUNT_ROW(symbols.symbols.intern(fields[0]), false); // the symbol is interned only if instrumented
+            return std::nullopt;
         }
-        bool valid_order(const std::string& condition_code)
+        static bool valid_order(std::string_view condition_code)
         {
             /* The function provide the validity of the order.
             Based on the passed arguments and formulas mentioned in the function,
@@ -137,55 +943,112 @@ class DataParser
             bool validity = (containsSubstring(condition_code, "XT") || condition_code == "@1");
             return validity;
         }
-        void save_orders(const std::string& destination_file) const
+        void save_orders(const std::string& destination_file, SummaryFormat format = SummaryFormat::Text) const
+        {
+            if (sharded_table)
+            {
+                sharded_table->save(destination_file, format);
+                return;
+            }
+            orders_table.save(destination_file, format);
+        }
+        bool save_checkpoint(const std::string& destination_file) const
+        {
+            /* Analytic state of the order table after the run (OrderTable::save_checkpoint) */
+            if (sharded_table)
+            {
+                return sharded_table->save_checkpoint(destination_file);
+            }
+            return orders_table.save_checkpoint(destination_file);
+        }
+        bool load_checkpoint(const std::string& source_file)
+        {
+            /* Continue from the state saved by an earlier run: called after set_shards_num and before start,
+            the statistics after the new file are those of a run over the earlier files and the new one
+            */
+            if (sharded_table)
+            {
+                return sharded_table->load_checkpoint(source_file);
+            }
+            return orders_table.load_checkpoint(source_file);
+        }
+        const Table& get_orders_table() const
+        {
+            return orders_table;
+        }
+        TimeIndex build_time_index() const
+        {
+            /* Point-in-time index of the loaded orders, see TimeIndex */
+            if (sharded_table)
+            {
+                return TimeIndex::build(*sharded_table);
+            }
+            return TimeIndex::build(orders_table);
+        }
+        void set_shards_num(unsigned int shards)
         {
-            orders_table.save(destination_file);
+            /* Analyse the order books on "shards" worker threads (ShardedOrderTable), 0 disables the sharding.
+            Must be called before reading the file
+            */
+            if (shards == 0)
+            {
+                sharded_table.reset();
+                return;
+            }
+            sharded_table.reset(new ShardedTable(shards, orders_table.get_options()));
+        }
+        const ShardedTable* get_sharded_table() const
+        {
+            return sharded_table.get();
         }
         void show_summary()
         {
             std::cout<<"Data Parser Details:"<<std::endl;
             std::cout<<"Data extracted from: ("<<file_path<<")"<<std::endl;
-            orders_table.show_summary();
+            if (sharded_table)
+            {
+                sharded_table->show_summary();
+            }
+            else
+            {
+                orders_table.show_summary();
+            }
+#ifdef ORDERBOOK_INSTRUMENTATION
+            Instrumentation::show_summary();
+#endif
         }
-        static std::vector<int> parse_date(const std::string& date)
+        static std::array<int, 3> parse_date(std::string_view date)
         {
             /* The date in string is represented as  20150420, which states: 
             Year: 2015
             Month: 04
-            Day: 2
+            Day: 20
             :param data is a string "20150420"
-            :returns [2015, 4, 2]
+            :returns [2015, 4, 20], zeros if the date is malformed
             */
-            std::vector<int> result;
-            int year = std::stoi(date.substr(0, 4));
-            int month = std::stoi(date.substr(4, 2));
-            int day = std::stoi(date.substr(6, 2));
-            result.push_back(year);
-            result.push_back(month);
-            result.push_back(day);
-
-            return result;
+            std::uint32_t value = 0;
+            if (!parse_number(date, value))
+            {
+                return {0, 0, 0};
+            }
+            return {static_cast<int>(value / 10000), static_cast<int>(value / 100 % 100), static_cast<int>(value % 100)};
         }
 
         static std::chrono::system_clock::time_point createTimePoint(int year, int month, int day, double seconds)
         {
             /* The date is converted to chrono time point based on:
             year, month, day and seconds, where
-            seconds counted past midnight
+            seconds counted past midnight (the fraction is kept)
             :returns time_point in chrono
             */
-            std::chrono::system_clock::time_point timePoint = std::chrono::system_clock::from_time_t(0);
-            timePoint += std::chrono::hours(24 * (day - 1));
-            timePoint += std::chrono::hours(24 * 30 * (month - 1));
-            timePoint += std::chrono::hours(24 * 365 * (year - 1970));
-            timePoint += std::chrono::seconds(static_cast<long long>(seconds));
-
-            return timePoint;
+            std::int64_t days = Timestamp::days_from_civil(year, static_cast<unsigned int>(month), static_cast<unsigned int>(day));
+            std::chrono::nanoseconds time(days * Timestamp::nanoseconds_per_day + std::llround(seconds * 1e9));
+            return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(time));
         }
 
-        static UpdateType process_type(short int update_type)
+        static std::optional<UpdateType> process_type(short int update_type)
         {
-            UpdateType type;
+            /* :returns empty optional for the update types other than [1, 3], such rows are rejected */
             switch (update_type)
             {
                 case 1:
@@ -200,11 +1063,13 @@ class DataParser
                 default:
                     break;
             }
-            return type;
+            return std::nullopt;
         }
 
-        static bool containsSubstring(const std::string& str, const std::string& substr) {
+        static bool containsSubstring(std::string_view str, std::string_view substr) {
             return str.find(substr) != std::string::npos;
         }
 
-};
\ No newline at end of file
+};
+
+using DataParser = BasicDataParser<Metrics::All>;
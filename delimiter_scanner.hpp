@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ORDERBOOK_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ORDERBOOK_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ORDERBOOK_TARGET_AVX2
+#endif
+
+enum class ScannerKind
+{
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+class DelimiterScanner
+{
+    /* Finds the positions of the structural characters of the input (',' '\r' '\n') for a whole block at once.
+    The vector kernels compare 16 (SSE2) or 64 (AVX2, two 32 byte registers) bytes per step against the delimiters
+    and turn the result into a bit mask, so each delimiter costs one bit scan instead of a compare per byte.
+    The best kernel supported by the CPU is selected at runtime, the scalar kernel is the fallback.
+    All kernels write the same positions, relative to the beginning of the block.
+    */
+    public:
+        typedef std::size_t (*Kernel)(const char* data, std::size_t length, std::uint32_t* positions);
+
+    private:
+        static bool is_delimiter(char c)
+        {
+            return c == ',' || c == '\n' || c == '\r';
+        }
+
+        static unsigned int trailing_zeros(std::uint64_t mask)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return static_cast<unsigned int>(index);
+#else
+            return static_cast<unsigned int>(__builtin_ctzll(mask));
+#endif
+        }
+
+        static std::size_t emit(std::uint64_t mask, std::uint32_t base, std::uint32_t* positions, std::size_t count)
+        {
+            while (mask != 0)
+            {
+                positions[count++] = base + trailing_zeros(mask);
+                mask &= mask - 1;
+            }
+            return count;
+        }
+
+        static std::size_t scan_tail(const char* data, std::size_t begin, std::size_t length,
+                                     std::uint32_t* positions, std::size_t count)
+        {
+            for (std::size_t i = begin; i < length; i++)
+            {
+                if (is_delimiter(data[i]))
+                {
+                    positions[count++] = static_cast<std::uint32_t>(i);
+                }
+            }
+            return count;
+        }
+
+#ifdef ORDERBOOK_X86
+        static std::size_t scan_sse2(const char* data, std::size_t length, std::uint32_t* positions)
+        {
+            const __m128i comma   = _mm_set1_epi8(',');
+            const __m128i newline = _mm_set1_epi8('\n');
+            const __m128i carriage = _mm_set1_epi8('\r');
+            std::size_t count = 0;
+            std::size_t i = 0;
+            for (; i + 16 <= length; i += 16)
+            {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, comma),
+                                                            _mm_cmpeq_epi8(chunk, newline)),
+                                               _mm_cmpeq_epi8(chunk, carriage));
+                std::uint64_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(matches));
+                count = emit(mask, static_cast<std::uint32_t>(i), positions, count);
+            }
+            return scan_tail(data, i, length, positions, count);
+        }
+
+        ORDERBOOK_TARGET_AVX2
+        static std::uint64_t mask_avx2(const char* data)
+        {
+            const __m256i comma   = _mm256_set1_epi8(',');
+            const __m256i newline = _mm256_set1_epi8('\n');
+            const __m256i carriage = _mm256_set1_epi8('\r');
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            __m256i matches = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, comma),
+                                                              _mm256_cmpeq_epi8(chunk, newline)),
+                                              _mm256_cmpeq_epi8(chunk, carriage));
+            return static_cast<std::uint32_t>(_mm256_movemask_epi8(matches));
+        }
+
+        ORDERBOOK_TARGET_AVX2
+        static std::size_t scan_avx2(const char* data, std::size_t length, std::uint32_t* positions)
+        {
+            std::size_t count = 0;
+            std::size_t i = 0;
+            for (; i + 64 <= length; i += 64)
+            {
+                std::uint64_t mask = mask_avx2(data + i) | (mask_avx2(data + i + 32) << 32);
+                count = emit(mask, static_cast<std::uint32_t>(i), positions, count);
+            }
+            return scan_tail(data, i, length, positions, count);
+        }
+
+        static bool cpu_supports_avx2()
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) { return false; }
+            __cpuidex(info, 7, 0);
+            bool avx2 = (info[1] & (1 << 5)) != 0;
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            return avx2 && osxsave && (_xgetbv(0) & 0x6) == 0x6;
+#else
+            return false;
+#endif
+        }
+#endif
+
+    public:
+        static std::size_t scan_scalar(const char* data, std::size_t length, std::uint32_t* positions)
+        {
+            return scan_tail(data, 0, length, positions, 0);
+        }
+
+        static bool supports(ScannerKind kind)
+        {
+#ifdef ORDERBOOK_X86
+            switch (kind)
+            {
+                case ScannerKind::Scalar:
+                case ScannerKind::SSE2:
+                    return true;
+                case ScannerKind::AVX2:
+                    return cpu_supports_avx2();
+            }
+            return false;
+#else
+            return kind == ScannerKind::Scalar;
+#endif
+        }
+
+        static Kernel kernel(ScannerKind kind)
+        {
+            /* :returns the kernel of the given kind, or the scalar kernel if the kind is not supported */
+#ifdef ORDERBOOK_X86
+            if (kind == ScannerKind::AVX2 && cpu_supports_avx2())
+            {
+                return &scan_avx2;
+            }
+            if (kind == ScannerKind::SSE2 || kind == ScannerKind::AVX2)
+            {
+                return &scan_sse2;
+            }
+#endif
+            (void)kind;
+            return &scan_scalar;
+        }
+
+        static ScannerKind best()
+        {
+            static const ScannerKind kind = supports(ScannerKind::AVX2) ? ScannerKind::AVX2
+                                          : supports(ScannerKind::SSE2) ? ScannerKind::SSE2
+                                          : ScannerKind::Scalar;
+            return kind;
+        }
+
+        static std::size_t scan(const char* data, std::size_t length, std::uint32_t* positions)
+        {
+            /* Scan with the best kernel of this CPU.
+            :param positions must have room for "length" entries
+            :returns the number of positions written
+            */
+            static const Kernel selected = kernel(best());
+            return selected(data, length, positions);
+        }
+};
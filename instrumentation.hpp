@@ -0,0 +1,377 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include "symbol_dictionary.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define ORDERBOOK_HAS_TSC 1
+#endif
+
+/* Hot path instrumentation, compiled in only if ORDERBOOK_INSTRUMENTATION is defined
+(cmake -DORDERBOOK_INSTRUMENTATION=ON). Without it the macros below expand to nothing.
+    ORDERBOOK_STAGE(Stage::Parse);                  times the rest of the enclosing scope
+    ORDERBOOK_COUNT_ROW(symbol, accepted);          counts a row read by the parser
+*/
+#ifdef ORDERBOOK_INSTRUMENTATION
+#define ORDERBOOK_STAGE_CONCAT(a, b) a##b
+#define ORDERBOOK_STAGE_NAME(line) ORDERBOOK_STAGE_CONCAT(stage_timer_, line)
+#define ORDERBOOK_STAGE(stage) StageTimer ORDERBOOK_STAGE_NAME(__LINE__)(stage)
+#define ORDERBOOK_COUNT_ROW(symbol, accepted) Instrumentation::count_row(symbol, accepted)
+#define ORDERBOOK_COUNT_MALFORMED() Instrumentation::count_malformed()
+#else
+#define ORDERBOOK_STAGE(stage) ((void)0)
+#define ORDERBOOK_COUNT_ROW(symbol, accepted) ((void)0)
+#define ORDERBOOK_COUNT_MALFORMED() ((void)0)
+#endif
+
+enum class Stage : std::uint8_t
+{
+    Read,     // one line read from the stream
+    Scan,     // delimiter scan of one block (memory-mapped and parallel modes)
+    Parse,    // conversion of the fields of one line
+    Validate, // valid_order
+    Build,    // process_order_details: symbol interning, timestamp and the Order
+    Analyze,  // OrderBook::analyze of one order
+};
+
+class Instrumentation
+{
+    /* Per-stage latency histograms and row counters.
+    Every thread writes to its own metrics without synchronisation, the metrics of all threads are merged
+    by snapshot(), which must not run concurrently with an ingest.
+    Only one call in sample_period of each stage is timed (the time stamp counter where available,
+    steady_clock otherwise), the calls themselves are always counted, which keeps the overhead low.
+    The latencies are kept in log-linear buckets: 4 sub-buckets per power of two, i.e. within 25%.
+    */
+    public:
+        static constexpr std::size_t stages_num = 6;
+        static constexpr std::size_t buckets_num = 256;
+        static constexpr std::uint64_t sample_period = 64;
+
+        struct StageStats
+        {
+            std::uint64_t calls = 0;
+            std::uint64_t samples = 0;
+            double mean_ns = 0.0;
+            double median_ns = 0.0;
+            double p99_ns = 0.0;
+            double max_ns = 0.0;
+        };
+
+        struct SymbolCounters
+        {
+            std::uint64_t accepted = 0;
+            std::uint64_t rejected = 0;
+        };
+
+        struct Snapshot
+        {
+            std::array<StageStats, stages_num> stages;
+            std::uint64_t rows_read = 0;
+            std::uint64_t rows_accepted = 0;
+            std::uint64_t rows_rejected = 0;  // including the malformed rows
+            std::uint64_t rows_malformed = 0; // rows with missing fields
+            std::vector<SymbolCounters> symbols; // indexed by SymbolId
+        };
+
+        struct ThreadMetrics
+        {
+            std::array<std::array<std::uint64_t, buckets_num>, stages_num> histograms{};
+            std::array<std::uint64_t, stages_num> calls{};
+            std::array<std::uint64_t, stages_num> ticks{};
+            std::array<std::uint64_t, stages_num> max_ticks{};
+            std::uint64_t malformed = 0;
+            std::vector<SymbolCounters> symbols;
+        };
+
+        static std::uint64_t now()
+        {
+#ifdef ORDERBOOK_HAS_TSC
+            return __rdtsc();
+#else
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+
+        static ThreadMetrics& local()
+        {
+            // a plain pointer is constant-initialized, so the access needs no thread_local guard
+            thread_local ThreadMetrics* metrics = nullptr;
+            if (metrics == nullptr)
+            {
+                metrics = registry().add().get(); // owned by the registry
+            }
+            return *metrics;
+        }
+
+        static void count_row(SymbolId symbol, bool accepted)
+        {
+            std::vector<SymbolCounters>& symbols = local().symbols;
+            if (symbols.size() <= symbol)
+            {
+                symbols.resize(symbol + 1);
+            }
+            if (accepted)
+            {
+                symbols[symbol].accepted++;
+            }
+            else
+            {
+                symbols[symbol].rejected++;
+            }
+        }
+
+        static void count_malformed()
+        {
+            local().malformed++;
+        }
+
+        static std::size_t bucket(std::uint64_t ticks)
+        {
+            if (ticks < 8)
+            {
+                return static_cast<std::size_t>(ticks);
+            }
+            unsigned int exponent = 63 - static_cast<unsigned int>(count_leading_zeros(ticks));
+            std::size_t index = exponent * 4 + ((ticks >> (exponent - 2)) & 3);
+            return index < buckets_num ? index : buckets_num - 1;
+        }
+
+        static double bucket_value(std::size_t index)
+        {
+            /* Middle of the bucket in ticks */
+            if (index < 8)
+            {
+                return static_cast<double>(index);
+            }
+            unsigned int exponent = static_cast<unsigned int>(index / 4);
+            double low = static_cast<double>((std::uint64_t(4) + index % 4) << (exponent - 2));
+            return low + static_cast<double>(std::uint64_t(1) << (exponent - 2)) / 2.0;
+        }
+
+        static double ns_per_tick()
+        {
+            /* Calibrated against steady_clock over the time since the first use of the instrumentation */
+#ifdef ORDERBOOK_HAS_TSC
+            const Registry& origin = registry();
+            std::uint64_t ticks = now() - origin.start_ticks;
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - origin.start_time).count();
+            return ticks == 0 ? 1.0 : ns / static_cast<double>(ticks);
+#else
+            return 1.0;
+#endif
+        }
+
+        static Snapshot snapshot()
+        {
+            Snapshot result;
+            std::array<std::array<std::uint64_t, buckets_num>, stages_num> histograms{};
+            std::array<std::uint64_t, stages_num> ticks{};
+            std::array<std::uint64_t, stages_num> max_ticks{};
+            {
+                Registry& all = registry();
+                std::lock_guard<std::mutex> lock(all.mutex);
+                for (const std::shared_ptr<ThreadMetrics>& metrics : all.threads)
+                {
+                    for (std::size_t s = 0; s < stages_num; s++)
+                    {
+                        result.stages[s].calls += metrics->calls[s];
+                        ticks[s] += metrics->ticks[s];
+                        max_ticks[s] = std::max(max_ticks[s], metrics->max_ticks[s]);
+                        for (std::size_t b = 0; b < buckets_num; b++)
+                        {
+                            histograms[s][b] += metrics->histograms[s][b];
+                        }
+                    }
+                    result.rows_malformed += metrics->malformed;
+                    if (result.symbols.size() < metrics->symbols.size())
+                    {
+                        result.symbols.resize(metrics->symbols.size());
+                    }
+                    for (std::size_t id = 0; id < metrics->symbols.size(); id++)
+                    {
+                        result.symbols[id].accepted += metrics->symbols[id].accepted;
+                        result.symbols[id].rejected += metrics->symbols[id].rejected;
+                    }
+                }
+            }
+            double scale = ns_per_tick();
+            for (std::size_t s = 0; s < stages_num; s++)
+            {
+                StageStats& stage = result.stages[s];
+                for (std::uint64_t count : histograms[s])
+                {
+                    stage.samples += count;
+                }
+                if (stage.samples == 0)
+                {
+                    continue;
+                }
+                stage.mean_ns = static_cast<double>(ticks[s]) / static_cast<double>(stage.samples) * scale;
+                stage.median_ns = quantile(histograms[s], stage.samples, 0.5) * scale;
+                stage.p99_ns = quantile(histograms[s], stage.samples, 0.99) * scale;
+                stage.max_ns = static_cast<double>(max_ticks[s]) * scale;
+            }
+            for (const SymbolCounters& counters : result.symbols)
+            {
+                result.rows_accepted += counters.accepted;
+                result.rows_rejected += counters.rejected;
+            }
+            result.rows_rejected += result.rows_malformed;
+            result.rows_read = result.rows_accepted + result.rows_rejected;
+            return result;
+        }
+
+        static void reset()
+        {
+            Registry& all = registry();
+            std::lock_guard<std::mutex> lock(all.mutex);
+            for (const std::shared_ptr<ThreadMetrics>& metrics : all.threads)
+            {
+                *metrics = ThreadMetrics();
+            }
+        }
+
+        static const char* stage_name(std::size_t stage)
+        {
+            static const char* const names[stages_num] = {"read", "scan", "parse", "validate", "build", "analyze"};
+            return names[stage];
+        }
+
+        static void show_summary(std::ostream& output = std::cout)
+        {
+            Snapshot result = snapshot();
+            output<<"Instrumentation:"<<std::endl;
+            output<<"Rows read: "<<result.rows_read<<", accepted: "<<result.rows_accepted
+                  <<", rejected: "<<result.rows_rejected<<" (malformed: "<<result.rows_malformed<<")"<<std::endl;
+            output<<std::left<<std::setw(12)<<"Stage"<<std::setw(14)<<"Calls"<<std::setw(12)<<"Samples"
+                  <<std::setw(12)<<"Mean ns"<<std::setw(12)<<"Median ns"<<std::setw(12)<<"p99 ns"<<"Max ns"<<std::endl;
+            for (std::size_t s = 0; s < stages_num; s++)
+            {
+                const StageStats& stage = result.stages[s];
+                if (stage.calls == 0)
+                {
+                    continue;
+                }
+                output<<std::left<<std::setw(12)<<stage_name(s)<<std::setw(14)<<stage.calls<<std::setw(12)<<stage.samples
+                      <<std::fixed<<std::setprecision(1)<<std::setw(12)<<stage.mean_ns<<std::setw(12)<<stage.median_ns
+                      <<std::setw(12)<<stage.p99_ns<<stage.max_ns<<std::endl;
+            }
+            output<<std::left<<std::setw(35)<<"Symbol"<<std::setw(12)<<"Accepted"<<"Rejected"<<std::endl;
+            const SymbolDictionary& dictionary = SymbolDictionary::global();
+            std::vector<SymbolId> ids;
+            for (std::size_t id = 0; id < result.symbols.size(); id++)
+            {
+                if (result.symbols[id].accepted + result.symbols[id].rejected != 0)
+                {
+                    ids.push_back(static_cast<SymbolId>(id));
+                }
+            }
+            std::sort(ids.begin(), ids.end(),
+                      [&dictionary](SymbolId a, SymbolId b) { return dictionary.name(a) < dictionary.name(b); });
+            for (SymbolId id : ids)
+            {
+                output<<std::left<<std::setw(35)<<dictionary.name(id)
+                      <<std::setw(12)<<result.symbols[id].accepted<<result.symbols[id].rejected<<std::endl;
+            }
+        }
+
+    private:
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadMetrics>> threads; // kept after the threads exit
+            std::uint64_t start_ticks = now();
+            std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+            std::shared_ptr<ThreadMetrics> add()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.push_back(std::make_shared<ThreadMetrics>());
+                return threads.back();
+            }
+        };
+
+        static Registry& registry()
+        {
+            static Registry all;
+            return all;
+        }
+
+        static unsigned int count_leading_zeros(std::uint64_t value)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return 63 - static_cast<unsigned int>(index);
+#else
+            return static_cast<unsigned int>(__builtin_clzll(value));
+#endif
+        }
+
+        static double quantile(const std::array<std::uint64_t, buckets_num>& histogram, std::uint64_t samples, double q)
+        {
+            std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(samples - 1));
+            std::uint64_t seen = 0;
+            for (std::size_t b = 0; b < buckets_num; b++)
+            {
+                seen += histogram[b];
+                if (seen > rank)
+                {
+                    return bucket_value(b);
+                }
+            }
+            return bucket_value(buckets_num - 1);
+        }
+
+};
+
+class StageTimer
+{
+    /* Times the scope it is declared in, see ORDERBOOK_STAGE */
+    private:
+        Instrumentation::ThreadMetrics& metrics;
+        std::size_t stage;
+        std::uint64_t start;
+        bool sampled;
+
+    public:
+        explicit StageTimer(Stage stage): metrics{Instrumentation::local()}, stage{static_cast<std::size_t>(stage)}, start{0}
+        {
+            sampled = metrics.calls[this->stage]++ % Instrumentation::sample_period == 0;
+            if (sampled)
+            {
+                start = Instrumentation::now();
+            }
+        }
+
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+
+        ~StageTimer()
+        {
+            if (sampled)
+            {
+                std::uint64_t elapsed = Instrumentation::now() - start;
+                metrics.histograms[stage][Instrumentation::bucket(elapsed)]++;
+                metrics.ticks[stage] += elapsed;
+                metrics.max_ticks[stage] = std::max(metrics.max_ticks[stage], elapsed);
+            }
+        }
+};
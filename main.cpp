@@ -14,7 +14,7 @@ int main()
     auto start = std::chrono::high_resolution_clock::now();
 
     DataParser parser = DataParser(file, data_limit);
-    parser.test_start();
+    parser.test_start(ReaderMode::MemoryMapped);
     parser.show_summary();
     parser.save_orders(destination_file);
 
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+    /* Read-only memory mapping of a whole file.
+    The content is accessed in place through data()/view(), the pages are loaded by the OS on demand,
+    so reading the file does not copy it into user-space buffers.
+    */
+    private:
+        const char* content;
+        std::size_t length;
+        bool opened;
+#ifdef _WIN32
+        HANDLE file;
+        HANDLE mapping;
+#else
+        int descriptor;
+#endif
+
+        void close()
+        {
+#ifdef _WIN32
+            if (content != nullptr) { UnmapViewOfFile(content); }
+            if (mapping != nullptr) { CloseHandle(mapping); }
+            if (file != INVALID_HANDLE_VALUE) { CloseHandle(file); }
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (content != nullptr) { munmap(const_cast<char*>(content), length); }
+            if (descriptor != -1) { ::close(descriptor); }
+            descriptor = -1;
+#endif
+            content = nullptr;
+            length = 0;
+            opened = false;
+        }
+
+    public:
+        explicit MappedFile(const std::string& path): content{nullptr}, length{0}, opened{false}
+#ifdef _WIN32
+                                                    , file{INVALID_HANDLE_VALUE}, mapping{nullptr}
+#else
+                                                    , descriptor{-1}
+#endif
+        {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) { return; }
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size)) { close(); return; }
+            length = static_cast<std::size_t>(size.QuadPart);
+            opened = true;
+            if (length == 0) { return; } // empty files cannot be mapped
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping == nullptr) { close(); return; }
+            content = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (content == nullptr) { close(); return; }
+#else
+            descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor == -1) { return; }
+            struct stat info;
+            if (fstat(descriptor, &info) != 0) { close(); return; }
+            length = static_cast<std::size_t>(info.st_size);
+            opened = true;
+            if (length == 0) { return; } // empty files cannot be mapped
+            void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (address == MAP_FAILED) { content = nullptr; close(); return; }
+            content = static_cast<const char*>(address);
+            madvise(address, length, MADV_SEQUENTIAL); // the parser reads the file front to back
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile() { close(); }
+
+        bool is_open() const { return opened; }
+
+        const char* data() const { return content; }
+
+        std::size_t size() const { return length; }
+
+        std::string_view view() const { return std::string_view(content, length); }
+};
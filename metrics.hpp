@@ -0,0 +1,17 @@
+#pragma once
+
+struct Metrics
+{
+    /* Compile-time selection of the statistics of the order books, the flags are combined with |,
+    e.g. BasicOrderTable<Metrics::Spreads | Metrics::TradeGaps>. The metrics which are not selected
+    are compiled out of BasicOrderBook::analyze and their columns are left out of the output.
+    OrderBook, OrderTable, ShardedOrderTable and DataParser compute all of them.
+    */
+    static constexpr unsigned int TradeGaps = 1 << 0;    // time between consecutive trades
+    static constexpr unsigned int TickGaps = 1 << 1;     // time between changes of the bid or the ask price
+    static constexpr unsigned int Spreads = 1 << 2;      // bid ask spread
+    static constexpr unsigned int RoundNumbers = 1 << 3; // last digits of the trade prices and volumes
+    static constexpr unsigned int All = TradeGaps | TickGaps | Spreads | RoundNumbers;
+
+    static constexpr bool has(unsigned int set, unsigned int metric) { return (set & metric) != 0; }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include "symbol_dictionary.hpp"
+
+enum class UpdateType : std::uint8_t
+{
+    Trade,
+    ChangeToBid,
+    ChangeToAsk,    
+};
+
+class Order
+{
+    /* Compact, trivially copyable event record (56 bytes, fits in a cache line).
+    Prices are fixed-point integers in ticks of 1 / price_scale, the time is in nanoseconds since the epoch,
+    the symbol and the condition code are interned ids and the date is kept as the yyyymmdd number.
+    */
+    public:
+        static constexpr std::int64_t price_scale = 10000; // ticks per currency unit
+
+    private:
+        std::int64_t bid_price;   // ticks
+        std::int64_t ask_price;   // ticks
+        std::int64_t trade_price; // ticks
+        std::int64_t time;        // nanoseconds since the epoch
+        SymbolId symbol;
+        std::uint32_t bid_volume;
+        std::uint32_t ask_volume;
+        std::uint32_t trade_volume;
+        std::uint32_t date;       // yyyymmdd
+        ConditionId condition_code;
+        UpdateType type;
+    public:
+        Order(SymbolId symb,
+            std::int64_t bid_p,
+            std::int64_t ask_p,
+            std::int64_t trade_p,
+            std::uint32_t bid_vol,
+            std::uint32_t ask_vol,
+            std::uint32_t trade_vol,
+            ConditionId condition_code,
+            UpdateType type,
+            std::uint32_t date,
+            std::int64_t timestamp):
+            bid_price{bid_p},
+            ask_price{ask_p},
+            trade_price{trade_p},
+            time{timestamp},
+            symbol{symb},
+            bid_volume{bid_vol},
+            ask_volume{ask_vol},
+            trade_volume{trade_vol},
+            date{date},
+            condition_code{condition_code},
+            type{type}
+        {}
+        static double to_price(std::int64_t ticks) { return static_cast<double>(ticks) / price_scale; }
+        SymbolId getSymbolId() const { return symbol; }
+        std::string_view getSymbol() const { return SymbolDictionary::global().name(symbol); }
+        double getBidPrice() const { return to_price(bid_price); }
+        double getAskPrice() const { return to_price(ask_price); }
+        double getTradePrice() const { return to_price(trade_price); }
+        double getBidAskSpread() const { return to_price(ask_price - bid_price); }
+        std::int64_t getBidTicks() const { return bid_price; }
+        std::int64_t getAskTicks() const { return ask_price; }
+        std::int64_t getTradeTicks() const { return trade_price; }
+        std::uint32_t getBidVolume() const { return bid_volume; }
+        std::uint32_t getAskVolume() const { return ask_volume; }
+        std::uint32_t getTradeVolume() const { return trade_volume; }
+        std::int64_t getTime() const { return time; }
+        std::chrono::system_clock::time_point getTimePoint() const
+        {
+            return std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(time)));
+        }
+        std::uint32_t getDate() const { return date; }
+        ConditionId getConditionId() const { return condition_code; }
+        std::string_view getConditionCode() const { return SymbolDictionary::conditions().name(condition_code); }
+        UpdateType getType() const { return type; }
+        void show_summary()
+        {
+            std::cout<<"Symbol: "<<getSymbol()<<std::endl;
+            std::cout<<"Condition Code: "<<getConditionCode()<<std::endl;
+        }
+};
+
+static_assert(std::is_trivially_copyable<Order>::value, "Order is copied with memcpy semantics");
+static_assert(sizeof(Order) <= 64, "Order must fit in a cache line");
@@ -1,284 +1,443 @@
+#pragma once
+
 #include <iostream>
 #include <iomanip>
 #include <string>
 #include <vector>
 #include <chrono>
-#include <map>
 #include <algorithm>
-#include <stack>
+#include <fstream>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include "statistics.hpp"
+#include "symbol_dictionary.hpp"
+#include "order.hpp"
+#include "order_columns.hpp"
+#include "instrumentation.hpp"
+#include "rolling_window.hpp"
+#include "round_number.hpp"
+#include "summary_formatter.hpp"
+#include "metrics.hpp"
+#include "checkpoint.hpp"
+#include "binary_io.hpp"
 
-enum class UpdateType
+enum class StorageMode
 {
-    Trade,
-    ChangeToBid,
-    ChangeToAsk,    
+    Rows,     // the orders are kept as a vector of Order records
+    Columnar, // the orders are kept as separate arrays per field (OrderColumns)
+    StatsOnly,  // no orders are kept, only the last quotes and the accumulators
 };
 
-class Order
+struct BookOptions
 {
-    private:
-        const std::string symbol;
-        double bid_price;
-        double ask_price;
-        double trade_price;
-        unsigned int bid_volume;
-        unsigned int ask_volume;
-        unsigned int trade_volume;
-        const std::string condition_code;
-        UpdateType type;
-        const std::string date;
-        std::chrono::system_clock::time_point time;
-    public:
-        Order(const std::string& symb,
-            double bid_p, 
-            double ask_p, 
-            double trade_p,
-            unsigned int bid_vol,
-            unsigned int ask_vol,
-            unsigned int trade_vol,
-            const std::string& condition_code,
-            UpdateType type,
-            const std::string date,
-            std::chrono::system_clock::time_point timestamp):
-            symbol{symb}, 
-            bid_price{bid_p},
-            ask_price{ask_p},
-            trade_price{trade_p},
-            bid_volume{bid_vol},
-            ask_volume{ask_vol},
-            trade_volume{trade_vol},
-            condition_code{condition_code},
-            type{type},
-            date{date},
-            time{timestamp}
-        {}
-        const std::string getSymbol() const { return symbol; }
-        double getBidPrice() const { return bid_price; }
-        double getAskPrice() const { return ask_price; }
-        double getTradePrice() const { return trade_price; }
-        double getBidAskSpread() const { return ask_price - bid_price; }
-        unsigned int getBidVolume() const { return bid_volume; }
-        unsigned int getAskVolume() const { return ask_volume; }
-        unsigned int getTradeVolume() const { return trade_volume; }
-        std::chrono::system_clock::time_point getTimePoint() const { return time; }
-        UpdateType getType() const { return type; }
-        ~Order() {}
-        void show_summary()
-        {
-            std::cout<<"Symbol: "<<symbol<<std::endl;
-            std::cout<<"Condition Code: "<<condition_code<<std::endl;
-        }
+    /* Configuration shared by all order books of a table */
+    StatisticsMode statistics;  // exact medians or bounded-memory quantile sketches
+    double relative_error;      // error bound of the quantile sketches (approximate mode only)
+    StorageMode storage;        // layout of the retained orders
+    std::vector<std::int64_t> windows; // durations (nanoseconds) of the rolling windows, e.g. minutes(1), minutes(5)
+    std::size_t window_capacity = 1 << 16; // maximum number of events of a metric in one window, the excess is counted as truncated
+    // decimal place of the price digit examined for the round number effect, the same for every symbol:
+    // a symbol quoted in coarser ticks (e.g. 0.05 at 2 decimals) only has the digits its tick allows,
+    // which is an artifact of the tick size rather than a preference of the traders
+    int round_number_decimals = 2;
+    BookOptions(StatisticsMode mode = StatisticsMode::Exact, double error = 0.01, StorageMode storage = StorageMode::Rows):
+        statistics{mode}, relative_error{error}, storage{storage} {}
+
+    static BookOptions stats_only(double error = 0.01)
+    {
+        /* Bounded-memory configuration: no orders are retained and the medians come from quantile sketches,
+        so the memory of a book does not depend on the number of its orders
+        */
+        return BookOptions(StatisticsMode::Approximate, error, StorageMode::StatsOnly);
+    }
 };
 
-class OrderBook
+struct WindowSummary
 {
-    /* The Order book represents the list of the order per symbol */
+    /* Statistics of the events within a rolling window ending at the latest order of the book
+    (the windows are not kept for earlier times)
+    */
+    std::int64_t duration; // nanoseconds
+    std::size_t trades;    // number of gaps between trades in the window
+    std::size_t ticks;     // number of gaps between tick changes
+    std::size_t quotes;    // number of spreads
+    double mean_time_trades;   // seconds
+    double median_time_trades;
+    double mean_time_tick;
+    double median_time_tick;
+    double mean_spread;
+    double median_spread;
+    std::uint64_t truncated; // events of the window dropped by BookOptions::window_capacity, the statistics miss them
+};
+
+template <unsigned int Set>
+class BasicOrderBook
+{
+    /* The Order book represents the list of the order per symbol.
+    Only the statistics of the metric set "Set" (Metrics) are computed, the others keep their initial values
+    */
     private:
-        const std::string symbol;
-        std::vector<Order> orders;
+        SymbolId symbol;
+        StorageMode storage;
+        std::vector<Order> orders;  // StorageMode::Rows
+        OrderColumns columns;       // StorageMode::Columnar
+        std::size_t orders_num = 0;
         double mean_time_trades;   // mean time between trades
-        double median_time_trades; // medina time between trades
         double longest_time_trades;
 
         double mean_time_tick;      // mean time between tick changes
-        double median_time_tick;    // median time between tick changes
         double longest_time_tick;   // longest time between tick changes
 
         double mean_spread;         // mean bid ask spread
-        double median_spread;       // median bid ask spread
+        // the medians are read from the accumulators on request (get_median_*), see update_statistics
 
-        std::vector<std::chrono::seconds> timeDifferences;
-        std::chrono::system_clock::time_point previousTradeTime;
+        RunningStats<long long> timeDifferences;     // nanoseconds between consecutive trades
+        std::int64_t previousTradeTime = 0; // nanoseconds, 0 if there was no trade yet
 
-        std::vector<std::chrono::seconds> timeTickDifferences;
-        std::stack<std::pair<double, Order>> bidPrices; // store the latest changes in the bid prices with its order
-        std::stack<std::pair<double, Order>> askPrices; // store the latest changes in the ask prices with its order
+        RunningStats<long long> timeTickDifferences; // nanoseconds between tick changes
+        struct Quote
+        {
+            /* Latest change of the bid or the ask price */
+            bool valid = false;
+            std::int64_t price = 0; // ticks
+            std::int64_t time = 0;  // nanoseconds
+        };
+        Quote bidPrices; // store the latest change in the bid prices
+        Quote askPrices; // store the latest change in the ask prices
 
-        std::vector<double> spreadList;
+        RunningStats<long long> spreadList; // ticks
 
-        static double get_mean(std::vector<std::chrono::seconds> time_diff)
+        struct Windows
         {
-            // Calculate the sum of time differences
-            std::chrono::seconds sumTimeDifferences(0);
-            for (const auto& timeDifference : time_diff)
-            {
-                sumTimeDifferences += timeDifference;
-            }
+            /* Rolling windows of one duration */
+            RollingWindow<std::int64_t> trade_gaps; // nanoseconds
+            RollingWindow<std::int64_t> tick_gaps;  // nanoseconds
+            RollingWindow<std::int64_t> spreads;    // ticks
+            Windows(std::int64_t duration, std::size_t capacity):
+                trade_gaps(duration, capacity), tick_gaps(duration, capacity), spreads(duration, capacity) {}
+        };
+        std::vector<Windows> windows; // one per BookOptions::windows
 
-            // Calculate the mean time between "Trade" orders
-            if (time_diff.empty())
+        RoundNumberStats roundNumbers; // last digits of the trade prices and volumes
+
+        static std::int64_t digit_divisor(int decimals)
+        {
+            /* Ticks per unit of the given decimal place, e.g. 100 for the cents */
+            std::int64_t divisor = Order::price_scale;
+            for (int i = 0; i < decimals && divisor > 1; i++)
             {
-                return 0.0;
+                divisor /= 10;
             }
-            return static_cast<double>(sumTimeDifferences.count()) / time_diff.size();
+            return divisor;
+        }
+
+        static double to_seconds(double nanoseconds)
+        {
+            return nanoseconds / 1e9;
         }
 
-        static double get_median(std::vector<std::chrono::seconds> time_diff)
+        void update_statistics()
         {
-            // Calculate the median time between "Trade" orders
-            if (time_diff.empty())
+            /* Refreshes the O(1) statistics after each order. The medians are not refreshed here:
+            in the approximate mode a median scans the buckets of the sketch
+            */
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps))
             {
-                return 0.0;
+                mean_time_trades    = to_seconds(timeDifferences.mean());
+                longest_time_trades = to_seconds(timeDifferences.max());
             }
-            std::sort(time_diff.begin(), time_diff.end()); // sort in place or new variable can be used to keep order
-
-            if (time_diff.size() % 2 == 0)
+            if constexpr (Metrics::has(Set, Metrics::TickGaps))
+            {
+                mean_time_tick      = to_seconds(timeTickDifferences.mean());
+                longest_time_tick   = to_seconds(timeTickDifferences.max());
+            }
+            if constexpr (Metrics::has(Set, Metrics::Spreads))
             {
-                // If the number of elements is even, take the average of the two middle elements
-                return static_cast<double>(time_diff[time_diff.size() / 2 - 1].count() + time_diff[time_diff.size() / 2].count()) / 2;
+                mean_spread         = spreadList.mean() / Order::price_scale;
             }
-            // If the number of elements is odd, take the middle element
-            return static_cast<double>(time_diff[time_diff.size() / 2].count());
-            
         }
 
-        static double get_largest(std::vector<std::chrono::seconds> time_diff)
+    public:
+        BasicOrderBook() = default;
+        BasicOrderBook(SymbolId symbol, const BookOptions& options = BookOptions()):symbol{symbol},
+                                            storage{options.storage},
+                                            mean_time_trades{0.0},
+                                            longest_time_trades{0.0},
+                                            mean_time_tick{0.0},
+                                            longest_time_tick{0.0},
+                                            mean_spread{0.0},
+                                            timeDifferences(options.statistics, options.relative_error),
+                                            timeTickDifferences(options.statistics, options.relative_error),
+                                            spreadList(options.statistics, options.relative_error),
+                                            roundNumbers(digit_divisor(options.round_number_decimals))
         {
-            std::sort(time_diff.begin(), time_diff.end());
-            if (!time_diff.empty())
+            for (std::int64_t duration : options.windows)
             {
-                return static_cast<double>(time_diff.back().count());
-            }
-            else
-            {
-                return 0.0;
+                windows.emplace_back(duration, options.window_capacity);
             }
         }
-
-        static double get_mean(const std::vector<double>& spreads)
+        BasicOrderBook(const BasicOrderBook&) = default;
+        BasicOrderBook(BasicOrderBook&&) = default; // the books are moved when the table grows
+        BasicOrderBook& operator=(const BasicOrderBook&) = default;
+        BasicOrderBook& operator=(BasicOrderBook&&) = default;
+        ~BasicOrderBook() {}
+        void addOrder(const Order& order)
         {
-            if (spreads.empty())
+            if (storage == StorageMode::Columnar)
             {
-                return 0.0;
+                columns.push_back(order);
             }
-
-            double sum = 0.0;
-            for (double spread : spreads)
+            else if (storage == StorageMode::Rows)
             {
-                sum += spread;
+                orders.push_back(order);
             }
-
-            return sum / spreads.size();
+            orders_num++;
+            analyze(order);
         }
 
-        static double get_median(std::vector<double> spreads)
+        void analyze(const Order& order)
         {
-            if (spreads.empty())
+            /* The function specify the order of statistical analysis over the orders.
+            The accumulators are updated incrementally, so each order costs O(log n).
+            The metrics outside of "Set" are discarded at compile time, not tested per order
+            */
+            ORDERBOOK_STAGE(Stage::Analyze);
+            for (Windows& window : windows)
             {
-                return 0.0;
+                // the windows end at the latest order, also for the metrics this order does not update
+                if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+                {
+                    window.trade_gaps.advance(order.getTime());
+                }
+                if constexpr (Metrics::has(Set, Metrics::TickGaps))
+                {
+                    window.tick_gaps.advance(order.getTime());
+                }
             }
-
-            std::sort(spreads.begin(), spreads.end());
-
-            if (spreads.size() % 2 == 0)
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps))
             {
-                return (spreads[spreads.size() / 2 - 1] + spreads[spreads.size() / 2]) / 2;
+                addTimeDifferenceTrade(order);
             }
-            else
+            if constexpr (Metrics::has(Set, Metrics::TickGaps))
             {
-                return spreads[spreads.size() / 2];
+                addTickTimeDifference(order);
             }
+            if constexpr (Metrics::has(Set, Metrics::Spreads))
+            {
+                addBidAskSpread(order);
+            }
+            if constexpr (Metrics::has(Set, Metrics::RoundNumbers))
+            {
+                addRoundNumbers(order);
+            }
+            update_statistics();
         }
 
-    public:
-        OrderBook() = default;
-        OrderBook(const std::string& symbol):symbol{symbol},
-                                            mean_time_trades{0.0},
-                                            median_time_trades{0.0},
-                                            longest_time_trades{0.0},
-                                            mean_time_tick{0.0},
-                                            median_time_tick{0.0},
-                                            longest_time_tick{0.0},
-                                            mean_spread{0.0},
-                                            median_spread{0.0}
-        {}
-        ~OrderBook() {}
-        void addOrder(Order order)
-        {
-            orders.push_back(order);
-            analyze(order);
-        }
-
-        void analyze(Order order)
+        void merge(const BasicOrderBook& other)
         {
-            /* The function specify the order of statistical analysis over the orders */
-            auto timeTradeDifferences = getTimeDifferencesTrade(order);
-            mean_time_trades    = get_mean(timeTradeDifferences);
-            median_time_trades  = get_median(timeTradeDifferences);
-            longest_time_trades = get_largest(timeTradeDifferences);
-
-            auto timeTickDifferences = getTickTimeDifferences(order);
-            
-            mean_time_tick      = get_mean(timeTickDifferences);
-            median_time_tick    = get_median(timeTickDifferences);
-            longest_time_tick   = get_largest(timeTickDifferences);
-
-            auto BidAskSpreads = getBidAskSpreadList(order);
-            
-            mean_spread         = get_mean(BidAskSpreads);
-            median_spread       = get_median(BidAskSpreads);
+            /* Combine the statistics of the same symbol collected from another shard or day.
+            The gaps spanning the boundary between the two sources are not counted,
+            the latest trade and quotes of "other" are kept for the following orders
+            */
+            if (storage == StorageMode::Columnar)
+            {
+                for (const Order& order : other.orders)
+                {
+                    columns.push_back(order);
+                }
+                columns.append(other.columns);
+            }
+            else if (storage == StorageMode::Rows)
+            {
+                orders.insert(orders.end(), other.orders.begin(), other.orders.end());
+                for (std::size_t i = 0; i < other.columns.size(); i++)
+                {
+                    orders.push_back(other.columns.row(i, symbol));
+                }
+            }
+            orders_num += other.orders_num;
+            timeDifferences.merge(other.timeDifferences);
+            timeTickDifferences.merge(other.timeTickDifferences);
+            spreadList.merge(other.spreadList);
+            roundNumbers.merge(other.roundNumbers);
+            if (other.previousTradeTime != 0)
+            {
+                previousTradeTime = other.previousTradeTime;
+            }
+            for (std::size_t i = 0; i < windows.size() && i < other.windows.size(); i++)
+            {
+                windows[i].trade_gaps.merge(other.windows[i].trade_gaps);
+                windows[i].tick_gaps.merge(other.windows[i].tick_gaps);
+                windows[i].spreads.merge(other.windows[i].spreads);
+            }
+            if (other.bidPrices.valid)
+            {
+                bidPrices = other.bidPrices;
+            }
+            if (other.askPrices.valid)
+            {
+                askPrices = other.askPrices;
+            }
+            update_statistics();
         }
 
-        std::vector<std::chrono::seconds> getTimeDifferencesTrade(Order order)
+        void addTimeDifferenceTrade(const Order& order)
         {
             /* The function determines the time difference between consecutive "Trade" orders */
             if (order.getType() == UpdateType::Trade)
             {
-                if (previousTradeTime != std::chrono::system_clock::time_point())
+                if (previousTradeTime != 0)
                 {
-                    std::chrono::seconds timeDifference = std::chrono::duration_cast<std::chrono::seconds>(order.getTimePoint() - previousTradeTime);
-                    timeDifferences.push_back(timeDifference);
+                    timeDifferences.add(order.getTime() - previousTradeTime);
+                    for (Windows& window : windows)
+                    {
+                        window.trade_gaps.add(order.getTime(), order.getTime() - previousTradeTime);
+                    }
                 }
-                previousTradeTime = order.getTimePoint();
+                previousTradeTime = order.getTime();
             }
-            return timeDifferences;
         }
         
-        std::vector<std::chrono::seconds> getTickTimeDifferences(Order order)
+        void addTickTimeDifference(const Order& order)
         {
             if (order.getType() == UpdateType::ChangeToBid)
             {
-                if (!bidPrices.empty())
+                if (bidPrices.valid)
                 {
-                    if (order.getBidPrice() == bidPrices.top().first) {return timeTickDifferences;} // no change in the price => no tick
-                    std::chrono::seconds timeDiff = std::chrono::duration_cast<std::chrono::seconds>(order.getTimePoint() - bidPrices.top().second.getTimePoint());
-                    timeTickDifferences.push_back(timeDiff);
-                    // askPrices.pop();
+                    if (order.getBidTicks() == bidPrices.price) {return;} // no change in the price => no tick
+                    timeTickDifferences.add(order.getTime() - bidPrices.time);
+                    for (Windows& window : windows)
+                    {
+                        window.tick_gaps.add(order.getTime(), order.getTime() - bidPrices.time);
+                    }
                 }
 
-                bidPrices.push(std::make_pair(order.getBidPrice(), order));
+                bidPrices = Quote{true, order.getBidTicks(), order.getTime()};
             }
             else if (order.getType() == UpdateType::ChangeToAsk)
             {
-                if (!askPrices.empty())
+                if (askPrices.valid)
                 {
-                    if (order.getBidPrice() == askPrices.top().first) {return timeTickDifferences;} // no change in the price => no tick
-                    std::chrono::seconds timeDiff = std::chrono::duration_cast<std::chrono::seconds>(order.getTimePoint() - askPrices.top().second.getTimePoint());
-                    timeTickDifferences.push_back(timeDiff);
-                    // bidPrices.pop();
+                    if (order.getBidTicks() == askPrices.price) {return;} // no change in the price => no tick
+                    timeTickDifferences.add(order.getTime() - askPrices.time);
+                    for (Windows& window : windows)
+                    {
+                        window.tick_gaps.add(order.getTime(), order.getTime() - askPrices.time);
+                    }
                 }
-                askPrices.push(std::make_pair(order.getBidPrice(), order));;
+                askPrices = Quote{true, order.getBidTicks(), order.getTime()};
             }
-            return timeTickDifferences;
         }
 
-        std::vector<double> getBidAskSpreadList(Order order)
+        void addBidAskSpread(const Order& order)
         {
-            double spread = order.getAskPrice() - order.getBidPrice();
-            spreadList.push_back(spread);
-            return spreadList;
+            spreadList.add(order.getAskTicks() - order.getBidTicks());
+            for (Windows& window : windows)
+            {
+                window.spreads.add(order.getTime(), order.getAskTicks() - order.getBidTicks());
+            }
+        }
+
+        void addRoundNumbers(const Order& order)
+        {
+            if (order.getType() == UpdateType::Trade)
+            {
+                roundNumbers.add(order.getTradeTicks(), order.getTradeVolume());
+            }
+        }
+
+        void save_state(BinaryWriter& out) const
+        {
+            /* Analytic state of the book for a Checkpoint, without the retained orders */
+            out.write<std::uint64_t>(orders_num);
+            out.write(previousTradeTime);
+            for (const Quote* quote : {&bidPrices, &askPrices})
+            {
+                out.write<std::uint8_t>(quote->valid);
+                out.write(quote->price);
+                out.write(quote->time);
+            }
+            timeDifferences.save_state(out);
+            timeTickDifferences.save_state(out);
+            spreadList.save_state(out);
+            roundNumbers.save_state(out);
+            for (const Windows& window : windows)
+            {
+                window.trade_gaps.save_state(out);
+                window.tick_gaps.save_state(out);
+                window.spreads.save_state(out);
+            }
+        }
+
+        bool load_state(BinaryReader& in)
+        {
+            /* Restores the state saved by save_state into a new book with the same options,
+            the following orders continue the statistics as if the book had seen the saved orders
+            */
+            std::uint64_t saved_orders = 0;
+            if (!in.read(saved_orders) || !in.read(previousTradeTime))
+            {
+                return false;
+            }
+            for (Quote* quote : {&bidPrices, &askPrices})
+            {
+                std::uint8_t valid = 0;
+                if (!in.read(valid) || !in.read(quote->price) || !in.read(quote->time))
+                {
+                    return false;
+                }
+                quote->valid = valid != 0;
+            }
+            if (!timeDifferences.load_state(in) || !timeTickDifferences.load_state(in) || !spreadList.load_state(in)
+                || !roundNumbers.load_state(in))
+            {
+                return false;
+            }
+            for (Windows& window : windows)
+            {
+                if (!window.trade_gaps.load_state(in) || !window.tick_gaps.load_state(in) || !window.spreads.load_state(in))
+                {
+                    return false;
+                }
+            }
+            orders_num = static_cast<std::size_t>(saved_orders);
+            update_statistics();
+            return true;
         }
 
         int get_orders_num() const
         {
-            return orders.size();
+            return orders_num;
+        }
+
+        StorageMode get_storage() const
+        {
+            return storage;
+        }
+
+        const std::vector<Order>& get_orders() const
+        {
+            /* Retained orders in the rows storage (empty in the other storage modes) */
+            return orders;
+        }
+
+        const OrderColumns& get_columns() const
+        {
+            /* Retained orders in the columnar storage (empty in the other storage modes) */
+            return columns;
         }
 
-        const std::string getSymbol() const 
+        SymbolId getSymbolId() const
         {
             return symbol;
         }
 
+        std::string_view getSymbol() const
+        {
+            return SymbolDictionary::global().name(symbol);
+        }
+
         double get_mean_time_trades() const
         {
             return mean_time_trades;
@@ -286,7 +445,15 @@ class OrderBook
 
         double get_median_time_trades() const
         {
-            return median_time_trades;
+            /* Read from the accumulator, O(bins of the sketch) in the approximate mode */
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+            {
+                return to_seconds(timeDifferences.median());
+            }
+            else
+            {
+                return 0.0;
+            }
         }
 
         double get_longest_time_trades() const
@@ -301,7 +468,14 @@ class OrderBook
 
         double get_median_time_tick() const
         {
-            return median_time_tick;
+            if constexpr (Metrics::has(Set, Metrics::TickGaps))
+            {
+                return to_seconds(timeTickDifferences.median());
+            }
+            else
+            {
+                return 0.0;
+            }
         }
 
         double get_longest_time_tick() const
@@ -316,98 +490,295 @@ class OrderBook
 
         double get_median_spread() const
         {
-            return median_spread;
+            if constexpr (Metrics::has(Set, Metrics::Spreads))
+            {
+                return spreadList.median() / Order::price_scale;
+            }
+            else
+            {
+                return 0.0;
+            }
+        }
+
+        std::size_t get_windows_num() const
+        {
+            return windows.size();
+        }
+
+        WindowSummary get_window_summary(std::size_t index) const
+        {
+            /* Statistics of the rolling window BookOptions::windows[index], no history is rescanned */
+            const Windows& window = windows[index];
+            return WindowSummary{window.spreads.get_duration(),
+                                 window.trade_gaps.size(), window.tick_gaps.size(), window.spreads.size(),
+                                 window.trade_gaps.mean() / 1e9, window.trade_gaps.median() / 1e9,
+                                 window.tick_gaps.mean() / 1e9, window.tick_gaps.median() / 1e9,
+                                 window.spreads.mean() / Order::price_scale, window.spreads.median() / Order::price_scale,
+                                 window.trade_gaps.get_truncated() + window.tick_gaps.get_truncated() + window.spreads.get_truncated()};
+        }
+
+        DigitHistogram get_price_digits() const
+        {
+            /* Last digits of the trade prices at BookOptions::round_number_decimals */
+            return roundNumbers.get_price_digits();
+        }
+
+        DigitHistogram get_volume_digits() const
+        {
+            return roundNumbers.get_volume_digits();
+        }
+
+        BookSummary get_summary() const
+        {
+            return BookSummary{symbol, mean_time_trades, get_median_time_trades(), longest_time_trades,
+                               mean_time_tick, get_median_time_tick(), longest_time_tick, mean_spread, get_median_spread()};
+        }
+
+        double get_percentile_time_trades(double q) const
+        {
+            /* :param q is within [0, 1], e.g. 0.99 for p99 */
+            return to_seconds(timeDifferences.quantile(q));
+        }
+
+        double get_percentile_time_tick(double q) const
+        {
+            return to_seconds(timeTickDifferences.quantile(q));
+        }
+
+        double get_percentile_spread(double q) const
+        {
+            return spreadList.quantile(q) / Order::price_scale;
         }
 
         void show_summary() const
         {
-            std::cout<<"============================================================================================="<<std::endl;
-            std::cout << std::left << std::setw(35) << "Symbol"
-                    << std::setw(20) << "Mean Trade Time"
-                    << std::setw(20) << "Median Trade Time"
-                    << std::setw(20) << "Longest Trade Time"
-                    << std::setw(20) << "Mean Tick Time"
-                    << std::setw(20) << "Median Tick Time"
-                    << std::setw(20) << "Longest Tick Time"
-                    << std::setw(20) << "Mean Spread"
-                    << std::setw(20) << "Median Spread"
-                    << std::endl;
-
-            std::cout << std::left << std::setw(35) << symbol
-                    << std::setw(20) << std::fixed << std::setprecision(6) << mean_time_trades
-                    << std::setw(20) << median_time_trades
-                    << std::setw(20) << longest_time_trades
-                    << std::setw(20) << std::fixed << std::setprecision(4) << mean_time_tick
-                    << std::setw(20) << median_time_tick
-                    << std::setw(20) << longest_time_tick
-                    << std::setw(20) << mean_spread
-                    << std::setw(20) << median_spread
-                    << std::endl;
+            std::string text;
+            append_summary(text, get_summary());
+            std::cout << text << std::flush;
+        }
+
+        static void append_summary(std::string& out, const BookSummary& summary)
+        {
+            /* The block of show_summary: a rule, the header and the row of the book */
+            out.append("=============================================================================================\n");
+            SummaryFormatter::append_header<Set>(out);
+            SummaryFormatter::append_row<Set>(out, SymbolDictionary::global().name(summary.symbol), summary);
         }
 };
 
-class OrderTable
+using OrderBook = BasicOrderBook<Metrics::All>;
+
+template <unsigned int Set>
+class BasicOrderTable
 {
+    /* Order books of all symbols, computing the statistics of the metric set "Set" (Metrics).
+    The outputs (show_summary, save, save_percentiles, save_windows) have the columns of the selected metrics only
+    */
+    public:
+        using Book = BasicOrderBook<Set>;
+
     private:
-        std::map<std::string, OrderBook> table;
-        void addOrderBook(Order order)
+        std::vector<Book> books;   // indexed by the slot of the symbol id (slot_of)
+        std::vector<bool> present; // the table has a book in the slot
+        int symbols_num = 0;
+        BookOptions options;
+        std::size_t stride = 1;    // the table holds only ids with the same remainder modulo stride
+        std::size_t slot_of(SymbolId symbol) const
         {
-            std::string symbol = order.getSymbol();
-            OrderBook book(symbol); // create new book
-            book.addOrder(order);
-            table.insert(std::make_pair(symbol, book));
+            return symbol / stride;
+        }
+        Book& addOrderBook(SymbolId symbol)
+        {
+            std::size_t slot = slot_of(symbol);
+            if (slot >= books.size())
+            {
+                books.resize(slot + 1);
+                present.resize(slot + 1, false);
+            }
+            books[slot] = Book(symbol, options); // create new book
+            present[slot] = true;
+            symbols_num++;
+            return books[slot];
         }
     public:
-        OrderTable() = default;
-        void processOrder(Order order)
+        BasicOrderTable() = default;
+        BasicOrderTable(const BookOptions& options): options{options} {}
+        BasicOrderTable(const BookOptions& options, std::size_t stride): options{options}, stride{std::max<std::size_t>(1, stride)}
+        {
+            /* Table of one shard of ShardedOrderTable: the symbol ids are all congruent modulo "stride",
+            so the books are indexed by id / stride and the table does not grow with the other shards' symbols
+            */
+        }
+        BasicOrderTable(const BasicOrderTable&) = default;
+        BasicOrderTable(BasicOrderTable&&) = default;
+        BasicOrderTable& operator=(const BasicOrderTable&) = default;
+        BasicOrderTable& operator=(BasicOrderTable&&) = default;
+        void processOrder(const Order& order)
         {
             /* Function appends the order to a specific order book based on the symbol 
-            As the result, order book will contain only the order with the same symbol type
+            As the result, order book will contain only the order with the same symbol type.
+            The book is found by the interned symbol id, i.e. a single array access
             */
-            if (is_symbol_exists(order.getSymbol()))
+            SymbolId symbol = order.getSymbolId();
+            std::size_t slot = slot_of(symbol);
+            if (slot < books.size() && present[slot])
             {
-                table[order.getSymbol()].addOrder(order);
+                books[slot].addOrder(order);
             }
             else
             {
-                addOrderBook(order);
+                addOrderBook(symbol).addOrder(order);
             }
         }
 
-        int getSymbolsNum() { return table.size(); }
+        int getSymbolsNum() const { return symbols_num; }
+
+        const BookOptions& get_options() const { return options; }
+
+        bool is_symbol_exists(SymbolId symbol) const
+        {
+            std::size_t slot = slot_of(symbol);
+            return slot < books.size() && present[slot] && books[slot].getSymbolId() == symbol;
+        }
+
+        bool is_symbol_exists(const std::string& symbol) const
+        {
+            SymbolId id;
+            return SymbolDictionary::global().find(symbol, id) && is_symbol_exists(id);
+        }
+
+        const Book& get_book(SymbolId symbol) const
+        {
+            return books[slot_of(symbol)];
+        }
+
+        std::vector<SymbolId> get_symbol_ids() const
+        {
+            /* Ids of the symbols in the table ordered by the symbol name (the order of the output) */
+            std::vector<SymbolId> ids;
+            for (std::size_t slot = 0; slot < books.size(); slot++)
+            {
+                if (present[slot])
+                {
+                    ids.push_back(books[slot].getSymbolId());
+                }
+            }
+            sort_by_name(ids);
+            return ids;
+        }
 
-        bool is_symbol_exists(const std::string& symbol)
+        static void sort_by_name(std::vector<SymbolId>& ids)
         {
-            auto it = table.find(symbol);
-            return it != table.end();
+            const SymbolDictionary& dictionary = SymbolDictionary::global();
+            std::sort(ids.begin(), ids.end(),
+                      [&dictionary](SymbolId a, SymbolId b) { return dictionary.name(a) < dictionary.name(b); });
         }
 
-        int getTotalOrders()
+        int getTotalOrders() const
         {
             int result = 0;
-            for(auto& pair: table)
+            for (std::size_t slot = 0; slot < books.size(); slot++)
             {
-                result += pair.second.get_orders_num();
+                if (present[slot])
+                {
+                    result += books[slot].get_orders_num();
+                }
             }
             return result;
         }
 
-        void show_summary()
+        void show_summary() const
         {
-            std::cout<<"Order Table Summary"<<std::endl;
-            std::cout<<"Number of Symbols in Order Table: "<<getSymbolsNum()<<std::endl;
-            for (const auto& pair: table) {
-                std::cout<<"\n\tOrder Book ("<<pair.second.get_orders_num()<<")\t"<<std::endl;
-                pair.second.show_summary();
+            std::vector<SymbolId> ids = get_symbol_ids();
+            std::vector<BookSummary> summaries;
+            std::vector<int> orders;
+            for (SymbolId id : ids)
+            {
+                summaries.push_back(get_book(id).get_summary());
+                orders.push_back(get_book(id).get_orders_num());
             }
-            std::cout<<"\nTotal number of Orders: "<<getTotalOrders()<<std::endl;
-            auto longest_trade = getLongestTimeTrades();
-            auto longest_tick  = getLongestTimeTick();
-            std::cout<<"Overall Longest Time between Trades: "<<longest_trade.first<<"|"<<longest_trade.second<<" seconds"<<std::endl;
-            std::cout<<"Overall Longest Time between Tick: "<<longest_tick.first<<"|"<<longest_tick.second<<" seconds"<<std::endl;
+            show_summary(summaries, orders, getTotalOrders(), getLongestTimeTrades(), getLongestTimeTick());
         }
-        void save(const std::string& destination_file) const
+
+        static void show_summary(const std::vector<BookSummary>& summaries, const std::vector<int>& orders, int total_orders,
+                                 const std::pair<std::string, double>& longest_trade,
+                                 const std::pair<std::string, double>& longest_tick)
         {
+            /* The blocks of the books are rendered by SummaryFormatter and written to std::cout at once */
+            std::cout<<"Order Table Summary"<<'\n';
+            std::cout<<"Number of Symbols in Order Table: "<<summaries.size()<<'\n';
+            std::string text;
+            SummaryFormatter::render(text, summaries.size(), 4 * SummaryFormatter::row_width, [&](std::string& part, std::size_t i)
+            {
+                part.append("\n\tOrder Book (");
+                part.append(std::to_string(orders[i]));
+                part.append(")\t\n");
+                Book::append_summary(part, summaries[i]);
+            });
+            std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+            if (!summaries.empty())
+            {
+                std::cout << std::fixed << std::setprecision(4); // the format the rows of the books left on the stream
+            }
+            std::cout<<"\nTotal number of Orders: "<<total_orders<<'\n';
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+            {
+                std::cout<<"Overall Longest Time between Trades: "<<longest_trade.first<<"|"<<longest_trade.second<<" seconds"<<'\n';
+            }
+            if constexpr (Metrics::has(Set, Metrics::TickGaps))
+            {
+                std::cout<<"Overall Longest Time between Tick: "<<longest_tick.first<<"|"<<longest_tick.second<<" seconds"<<'\n';
+            }
+            std::cout<<std::flush;
+        }
+        void save(const std::string& destination_file, SummaryFormat format = SummaryFormat::Text) const
+        {
+            /* The table is rendered in memory by SummaryFormatter and written with a single write call,
+            SummaryFormat::Csv writes the machine-readable variant of the same table
+            */
+            SummaryFormatter::write(destination_file, SummaryFormatter::format<Set>(get_summaries(), format));
+        }
+
+        static void save_header(std::ostream& file)
+        {
+            std::string text;
+            SummaryFormatter::append_header<Set>(text);
+            file << text;
+        }
+
+        static void save_row(std::ostream& file, std::string_view symbol, const Book& book)
+        {
+            save_row(file, symbol, book.get_summary());
+        }
+
+        static void save_row(std::ostream& file, std::string_view symbol, const BookSummary& summary)
+        {
+            std::string text;
+            SummaryFormatter::append_row<Set>(text, symbol, summary);
+            file << text;
+        }
+
+        std::vector<BookSummary> get_summaries() const
+        {
+            /* Statistics of all books in the order of the output, an O(symbols) copy of the current state */
+            std::vector<BookSummary> summaries;
+            for (SymbolId id : get_symbol_ids())
+            {
+                summaries.push_back(get_book(id).get_summary());
+            }
+            return summaries;
+        }
+
+        static void save_summaries(std::ostream& file, const std::vector<BookSummary>& summaries)
+        {
+            /* Same output as save() for the summaries taken by get_summaries() */
+            std::string text = SummaryFormatter::format<Set>(summaries);
+            file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+
+        void save_percentiles(const std::string& destination_file, const std::vector<double>& quantiles) const
+        {
+            /* Save the requested quantiles (e.g. {0.5, 0.9, 0.99}) of the trade time, tick time and spread per symbol */
             std::ofstream file(destination_file);
             if (!file)
             {
@@ -415,35 +786,251 @@ class OrderTable
                 return;
             }
 
-            file << std::left << std::setw(35) << "Symbol"
-                << std::setw(20) << "Mean Trade Time"
-                << std::setw(20) << "Median Trade Time"
-                << std::setw(20) << "Longest Trade Time"
-                << std::setw(20) << "Mean Tick Time"
-                << std::setw(20) << "Median Tick Time"
-                << std::setw(20) << "Longest Tick Time"
-                << std::setw(20) << "Mean Spread"
-                << std::setw(20) << "Median Spread"
-                << std::endl;
+            std::vector<const char*> metrics;
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps)) { metrics.push_back("Trade Time"); }
+            if constexpr (Metrics::has(Set, Metrics::TickGaps)) { metrics.push_back("Tick Time"); }
+            if constexpr (Metrics::has(Set, Metrics::Spreads)) { metrics.push_back("Spread"); }
+            file << std::left << std::setw(35) << "Symbol";
+            for (const char* metric : metrics)
+            {
+                for (double q : quantiles)
+                {
+                    file << std::setw(20) << ("P" + std::to_string(static_cast<int>(std::round(q * 100))) + " " + metric);
+                }
+            }
+            file << std::endl;
 
-            for (const auto& pair : table)
+            for (SymbolId id : get_symbol_ids())
             {
-                const std::string& symbol = pair.first;
-                const OrderBook& book = pair.second;
+                const Book& book = get_book(id);
+                file << std::left << std::setw(35) << book.getSymbol() << std::fixed << std::setprecision(4);
+                if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+                {
+                    for (double q : quantiles)
+                    {
+                        file << std::setw(20) << book.get_percentile_time_trades(q);
+                    }
+                }
+                if constexpr (Metrics::has(Set, Metrics::TickGaps))
+                {
+                    for (double q : quantiles)
+                    {
+                        file << std::setw(20) << book.get_percentile_time_tick(q);
+                    }
+                }
+                if constexpr (Metrics::has(Set, Metrics::Spreads))
+                {
+                    for (double q : quantiles)
+                    {
+                        file << std::setw(20) << book.get_percentile_spread(q);
+                    }
+                }
+                file << std::endl;
+            }
+        }
 
-                file << std::left << std::setw(35) << symbol
-                    << std::setw(20) << std::fixed << std::setprecision(6) << book.get_mean_time_trades()
-                    << std::setw(20) << book.get_median_time_trades()
-                    << std::setw(20) << book.get_longest_time_trades()
-                    << std::setw(20) << std::fixed << std::setprecision(4) << book.get_mean_time_tick()
-                    << std::setw(20) << book.get_median_time_tick()
-                    << std::setw(20) << book.get_longest_time_tick()
-                    << std::setw(20) << book.get_mean_spread()
-                    << std::setw(20) << book.get_median_spread()
-                    << std::endl;
+        DigitHistogram get_price_digits() const
+        {
+            /* Table-wide last digits of the trade prices */
+            DigitHistogram result;
+            for (std::size_t slot = 0; slot < books.size(); slot++)
+            {
+                if (present[slot])
+                {
+                    result.merge(books[slot].get_price_digits());
+                }
             }
+            return result;
+        }
 
-            file.close();
+        DigitHistogram get_volume_digits() const
+        {
+            DigitHistogram result;
+            for (std::size_t slot = 0; slot < books.size(); slot++)
+            {
+                if (present[slot])
+                {
+                    result.merge(books[slot].get_volume_digits());
+                }
+            }
+            return result;
+        }
+
+        static void save_digits_row(std::ostream& file, std::string_view symbol, const char* values,
+                                    const DigitHistogram& histogram)
+        {
+            file << std::left << std::setw(35) << symbol << std::setw(10) << values
+                << std::setw(14) << histogram.total() << std::fixed << std::setprecision(4);
+            for (unsigned int d = 0; d < 10; d++)
+            {
+                file << std::setw(10) << histogram.share(d);
+            }
+            file << std::setw(16) << histogram.chi_square() << std::scientific << std::setprecision(4)
+                << histogram.p_value() << std::defaultfloat << std::endl;
+        }
+
+        void save_round_numbers(const std::string& destination_file) const
+        {
+            /* Save the round number effect: the share of every last digit of the trade prices and volumes
+            per symbol and for the whole table ("All"), with the chi-square statistic against the uniform
+            distribution and its p-value (a small p-value means the digits are not uniform).
+            The first line states the examined decimal place, which is not adjusted to the tick size of a symbol
+            */
+            std::ofstream file(destination_file);
+            if (!file)
+            {
+                std::cerr << "Failed to open file for writing: " << destination_file << std::endl;
+                return;
+            }
+
+            file << "Price digit at " << options.round_number_decimals << " decimal places for every symbol, "
+                 << "symbols with a coarser tick size only show the digits their tick allows" << std::endl;
+            file << std::left << std::setw(35) << "Symbol" << std::setw(10) << "Values" << std::setw(14) << "Trades";
+            for (unsigned int d = 0; d < 10; d++)
+            {
+                file << std::setw(10) << ("Digit " + std::to_string(d));
+            }
+            file << std::setw(16) << "Chi Square" << "P Value" << std::endl;
+
+            for (SymbolId id : get_symbol_ids())
+            {
+                const Book& book = get_book(id);
+                save_digits_row(file, book.getSymbol(), "Price", book.get_price_digits());
+                save_digits_row(file, book.getSymbol(), "Volume", book.get_volume_digits());
+            }
+            save_digits_row(file, "All", "Price", get_price_digits());
+            save_digits_row(file, "All", "Volume", get_volume_digits());
+        }
+
+        void save_windows(const std::string& destination_file) const
+        {
+            /* Save the rolling window statistics (BookOptions::windows) per symbol, one row per window */
+            std::ofstream file(destination_file);
+            if (!file)
+            {
+                std::cerr << "Failed to open file for writing: " << destination_file << std::endl;
+                return;
+            }
+
+            file << std::left << std::setw(35) << "Symbol" << std::setw(10) << "Window";
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+            {
+                file << std::setw(20) << "Mean Trade Time" << std::setw(20) << "Median Trade Time";
+            }
+            if constexpr (Metrics::has(Set, Metrics::TickGaps))
+            {
+                file << std::setw(20) << "Mean Tick Time" << std::setw(20) << "Median Tick Time";
+            }
+            if constexpr (Metrics::has(Set, Metrics::Spreads))
+            {
+                file << std::setw(20) << "Mean Spread" << std::setw(20) << "Median Spread";
+            }
+            file << std::endl;
+
+            std::uint64_t truncated = 0;
+            for (SymbolId id : get_symbol_ids())
+            {
+                const Book& book = get_book(id);
+                for (std::size_t i = 0; i < book.get_windows_num(); i++)
+                {
+                    WindowSummary window = book.get_window_summary(i);
+                    truncated += window.truncated;
+                    std::int64_t seconds = window.duration / 1000000000;
+                    std::string label = seconds % 60 == 0 ? std::to_string(seconds / 60) + "m" : std::to_string(seconds) + "s";
+                    file << std::left << std::setw(35) << book.getSymbol()
+                        << std::setw(10) << label << std::fixed << std::setprecision(4);
+                    if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+                    {
+                        file << std::setw(20) << window.mean_time_trades << std::setw(20) << window.median_time_trades;
+                    }
+                    if constexpr (Metrics::has(Set, Metrics::TickGaps))
+                    {
+                        file << std::setw(20) << window.mean_time_tick << std::setw(20) << window.median_time_tick;
+                    }
+                    if constexpr (Metrics::has(Set, Metrics::Spreads))
+                    {
+                        file << std::setw(20) << window.mean_spread << std::setw(20) << window.median_spread;
+                    }
+                    file << std::endl;
+                }
+            }
+            if (truncated > 0)
+            {
+                std::cerr << "Rolling windows dropped " << truncated << " events over BookOptions::window_capacity ("
+                          << options.window_capacity << "), the window statistics are incomplete" << std::endl;
+            }
+        }
+
+        static Checkpoint::Settings checkpoint_settings(const BookOptions& options)
+        {
+            return Checkpoint::Settings{Set, options.statistics, options.relative_error, options.round_number_decimals,
+                                        options.window_capacity, options.windows};
+        }
+
+        bool save_checkpoint(const std::string& destination_file) const
+        {
+            /* Save the analytic state of all books (Checkpoint), e.g. after the run over a trading day.
+            The retained orders are not saved
+            */
+            std::vector<const Book*> list;
+            for (SymbolId id : get_symbol_ids())
+            {
+                list.push_back(&get_book(id));
+            }
+            if (!Checkpoint::write(destination_file, list, checkpoint_settings(options)))
+            {
+                std::cerr << "Failed to write the checkpoint: " << destination_file << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        bool load_checkpoint(const std::string& source_file)
+        {
+            /* Replace the books by the ones saved by save_checkpoint, before the orders of the new data.
+            The table must use the same options (except the storage mode) and metric set as the saved one,
+            the statistics after the new orders are then equal to a run over the old and the new data.
+            On failure the table is left unchanged
+            */
+            BasicOrderTable loaded(options, stride);
+            std::string error;
+            if (!Checkpoint::read(source_file, checkpoint_settings(options),
+                                  [&loaded](SymbolId symbol, BinaryReader& in) { return loaded.load_book(symbol, in); }, error))
+            {
+                std::cerr << "Failed to load the checkpoint: " << source_file << " (" << error << ")" << std::endl;
+                return false;
+            }
+            *this = std::move(loaded);
+            return true;
+        }
+
+        bool load_book(SymbolId symbol, BinaryReader& in)
+        {
+            /* Add the book of the symbol with the state saved by BasicOrderBook::save_state */
+            return !is_symbol_exists(symbol) && addOrderBook(symbol).load_state(in);
+        }
+
+        void merge(const BasicOrderTable& other)
+        {
+            /* Combine the order books of another table (e.g. another shard or trading day) into this one
+            without re-reading the data. Both tables must use the same statistics mode and error bound
+            */
+            for (std::size_t slot = 0; slot < other.books.size(); slot++)
+            {
+                if (!other.present[slot])
+                {
+                    continue;
+                }
+                const Book& book = other.books[slot];
+                if (is_symbol_exists(book.getSymbolId()))
+                {
+                    books[slot_of(book.getSymbolId())].merge(book);
+                }
+                else
+                {
+                    addOrderBook(book.getSymbolId()).merge(book);
+                }
+            }
         }
 
         std::pair<std::string, double> getLongestTimeTrades() const
@@ -451,12 +1038,12 @@ class OrderTable
             /* Function determines the longest time between trades among all stocks */
             std::pair<std::string, double> longestTimeTrades;
 
-            for (const auto& pair : table)
+            for (SymbolId id : get_symbol_ids())
             {
-                double longestTime = pair.second.get_longest_time_trades();
+                double longestTime = get_book(id).get_longest_time_trades();
                 if (longestTime > longestTimeTrades.second)
                 {
-                    longestTimeTrades = { pair.first, longestTime };
+                    longestTimeTrades = { std::string(get_book(id).getSymbol()), longestTime };
                 }
             }
 
@@ -468,16 +1055,17 @@ class OrderTable
             /* Function determines the longest time between tick among all stocks */
             std::pair<std::string, double> longestTimeTick;
 
-            for (const auto& pair : table)
+            for (SymbolId id : get_symbol_ids())
             {
-                double longestTime = pair.second.get_longest_time_tick();
+                double longestTime = get_book(id).get_longest_time_tick();
                 if (longestTime > longestTimeTick.second)
                 {
-                    longestTimeTick = { pair.first, longestTime };
+                    longestTimeTick = { std::string(get_book(id).getSymbol()), longestTime };
                 }
             }
 
             return longestTimeTick;
         }
-        ~OrderTable() {}
-};
\ No newline at end of file
+        ~BasicOrderTable() {}
+};
+using OrderTable = BasicOrderTable<Metrics::All>;
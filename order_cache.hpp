@@ -0,0 +1,301 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "order.hpp"
+#include "order_columns.hpp"
+#include "symbol_dictionary.hpp"
+#include "mapped_file.hpp"
+
+class OrderCache
+{
+    /* Binary columnar cache of a parsed input file.
+    The file is written once after the first parse of the text input and memory-mapped by the following runs,
+    the orders are read from the columns in place, so loading costs only the page faults.
+
+    Layout (native byte order, every section starts at a multiple of 8 bytes):
+        Header
+        Entry[symbols_num]        one per symbol: name and position of its block
+        Name[conditions_num]      names of the condition codes, indexed by the ids stored in the blocks
+        names                     characters of the symbol and condition names
+        blocks                    one per symbol, the columns of its orders in the file order:
+                                  times, bid, ask, trade (int64) | bid, ask, trade volumes, dates (uint32)
+                                  | conditions (uint16) | types (uint8)
+    The symbol and condition ids of the file are remapped to the ids of the running process on load.
+    The source size and modification time are stored, so a cache of a changed input is detected as stale.
+    */
+    public:
+        static constexpr char magic[8] = {'O', 'B', 'C', 'A', 'C', 'H', 'E', '\0'};
+        static constexpr std::uint32_t version = 2; // 2: exact calendar and sub-second timestamps
+
+        struct Header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t price_scale;
+            std::uint32_t symbols_num;
+            std::uint32_t conditions_num;
+            std::uint64_t orders_num;
+            std::uint64_t source_size;
+            std::int64_t source_time;
+            std::uint64_t names_offset;
+            std::uint64_t names_size;
+        };
+
+        struct Entry
+        {
+            std::uint32_t name_offset;
+            std::uint32_t name_length;
+            std::uint64_t rows;
+            std::uint64_t offset; // beginning of the block
+        };
+
+        struct Name
+        {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
+        static std::uint64_t align(std::uint64_t offset)
+        {
+            return (offset + 7) & ~std::uint64_t(7);
+        }
+
+        static constexpr std::uint64_t row_bytes = 4 * sizeof(std::int64_t) + 4 * sizeof(std::uint32_t) + sizeof(ConditionId) + 1;
+
+        static std::uint64_t block_size(std::uint64_t rows)
+        {
+            return align(rows * row_bytes);
+        }
+
+        static bool write(const std::string& path, const std::vector<OrderColumns>& books,
+                          std::uint64_t source_size, std::int64_t source_time)
+        {
+            /* Write the cache of the books indexed by SymbolId, the empty books are skipped.
+            :returns false if the file cannot be written
+            */
+            const SymbolDictionary& symbols = SymbolDictionary::global();
+            const SymbolDictionary& conditions = SymbolDictionary::conditions();
+            std::vector<Entry> entries;
+            std::vector<Name> condition_names;
+            std::string names;
+            std::uint64_t orders_num = 0;
+            for (std::size_t id = 0; id < books.size(); id++)
+            {
+                if (books[id].empty())
+                {
+                    continue;
+                }
+                std::string_view name = symbols.name(static_cast<SymbolId>(id));
+                entries.push_back(Entry{static_cast<std::uint32_t>(names.size()), static_cast<std::uint32_t>(name.size()),
+                                        books[id].size(), 0});
+                names += name;
+                orders_num += books[id].size();
+            }
+            std::size_t conditions_num = conditions.size();
+            for (std::size_t id = 0; id < conditions_num; id++)
+            {
+                std::string_view name = conditions.name(static_cast<SymbolId>(id));
+                condition_names.push_back(Name{static_cast<std::uint32_t>(names.size()), static_cast<std::uint32_t>(name.size())});
+                names += name;
+            }
+
+            Header header;
+            std::memcpy(header.magic, magic, sizeof(magic));
+            header.version = version;
+            header.price_scale = static_cast<std::uint32_t>(Order::price_scale);
+            header.symbols_num = static_cast<std::uint32_t>(entries.size());
+            header.conditions_num = static_cast<std::uint32_t>(condition_names.size());
+            header.orders_num = orders_num;
+            header.source_size = source_size;
+            header.source_time = source_time;
+            header.names_offset = sizeof(Header) + entries.size() * sizeof(Entry) + condition_names.size() * sizeof(Name);
+            header.names_size = names.size();
+
+            std::uint64_t offset = align(header.names_offset + header.names_size);
+            for (Entry& entry : entries)
+            {
+                entry.offset = offset;
+                offset += block_size(entry.rows);
+            }
+
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+            file.write(reinterpret_cast<const char*>(condition_names.data()), condition_names.size() * sizeof(Name));
+            file.write(names.data(), names.size());
+            pad(file, header.names_offset + header.names_size);
+            for (const OrderColumns& book : books)
+            {
+                if (book.empty())
+                {
+                    continue;
+                }
+                std::uint64_t written = 0;
+                written += write_column(file, book.get_times());
+                written += write_column(file, book.get_bid_prices());
+                written += write_column(file, book.get_ask_prices());
+                written += write_column(file, book.get_trade_prices());
+                written += write_column(file, book.get_bid_volumes());
+                written += write_column(file, book.get_ask_volumes());
+                written += write_column(file, book.get_trade_volumes());
+                written += write_column(file, book.get_dates());
+                written += write_column(file, book.get_conditions());
+                written += write_column(file, book.get_types());
+                pad(file, written);
+            }
+            return file.good();
+        }
+
+    private:
+        template <typename T>
+        static std::uint64_t write_column(std::ofstream& file, const std::vector<T>& column)
+        {
+            file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+            return column.size() * sizeof(T);
+        }
+
+        static void pad(std::ofstream& file, std::uint64_t written)
+        {
+            static const char zeros[8] = {};
+            file.write(zeros, align(written) - written);
+        }
+};
+
+class OrderCacheReader
+{
+    /* Memory-mapped view of a file written by OrderCache::write */
+    private:
+        MappedFile file;
+        const OrderCache::Header* header = nullptr;
+        const OrderCache::Entry* entries = nullptr;
+        const OrderCache::Name* conditions = nullptr;
+        const char* names = nullptr;
+
+        static bool fits(std::uint64_t offset, std::uint64_t length, std::uint64_t size)
+        {
+            /* :returns true if [offset, offset + length) lies within [0, size), without overflowing */
+            return offset <= size && length <= size - offset;
+        }
+
+        bool validate()
+        {
+            /* Every offset and length of the header and the index is checked against the size of the mapping,
+            so a truncated or corrupt cache is rejected instead of being read out of bounds
+            */
+            if (!file.is_open() || file.size() < sizeof(OrderCache::Header))
+            {
+                return false;
+            }
+            const OrderCache::Header* candidate = reinterpret_cast<const OrderCache::Header*>(file.data());
+            if (std::memcmp(candidate->magic, OrderCache::magic, sizeof(OrderCache::magic)) != 0
+                || candidate->version != OrderCache::version
+                || candidate->price_scale != static_cast<std::uint32_t>(Order::price_scale))
+            {
+                return false;
+            }
+            std::uint64_t index_end = sizeof(OrderCache::Header) + std::uint64_t(candidate->symbols_num) * sizeof(OrderCache::Entry)
+                                    + std::uint64_t(candidate->conditions_num) * sizeof(OrderCache::Name);
+            if (candidate->names_offset != index_end || !fits(index_end, candidate->names_size, file.size()))
+            {
+                return false;
+            }
+            const OrderCache::Entry* index = reinterpret_cast<const OrderCache::Entry*>(file.data() + sizeof(OrderCache::Header));
+            for (std::uint32_t i = 0; i < candidate->symbols_num; i++)
+            {
+                const OrderCache::Entry& entry = index[i];
+                if (entry.offset % 8 != 0 || entry.offset > file.size()
+                    || entry.rows > (file.size() - entry.offset) / OrderCache::row_bytes
+                    || !fits(entry.name_offset, entry.name_length, candidate->names_size))
+                {
+                    return false;
+                }
+            }
+            const OrderCache::Name* condition_index = reinterpret_cast<const OrderCache::Name*>(index + candidate->symbols_num);
+            for (std::uint32_t i = 0; i < candidate->conditions_num; i++)
+            {
+                if (!fits(condition_index[i].offset, condition_index[i].length, candidate->names_size))
+                {
+                    return false;
+                }
+            }
+            header = candidate;
+            entries = index;
+            conditions = condition_index;
+            names = file.data() + header->names_offset;
+            return true;
+        }
+
+        std::string_view name(std::uint32_t offset, std::uint32_t length) const
+        {
+            return std::string_view(names + offset, length);
+        }
+
+    public:
+        explicit OrderCacheReader(const std::string& path): file(path)
+        {
+            validate();
+        }
+
+        bool is_valid() const { return header != nullptr; }
+
+        bool matches(std::uint64_t source_size, std::int64_t source_time) const
+        {
+            /* :returns true if the cache has been written for the source of this size and modification time */
+            return is_valid() && header->source_size == source_size && header->source_time == source_time;
+        }
+
+        std::size_t getSymbolsNum() const { return is_valid() ? header->symbols_num : 0; }
+
+        std::uint64_t getTotalOrders() const { return is_valid() ? header->orders_num : 0; }
+
+        template <typename Sink>
+        void load(Sink&& sink) const
+        {
+            /* Pass the orders to the sink symbol by symbol, the orders of every symbol in the original file order */
+            if (!is_valid())
+            {
+                return;
+            }
+            std::vector<ConditionId> condition_ids(header->conditions_num);
+            SymbolDictionary& condition_dictionary = SymbolDictionary::conditions();
+            for (std::uint32_t i = 0; i < header->conditions_num; i++)
+            {
+                condition_ids[i] = static_cast<ConditionId>(condition_dictionary.intern(name(conditions[i].offset, conditions[i].length)));
+            }
+            SymbolDictionary& symbol_dictionary = SymbolDictionary::global();
+            for (std::uint32_t s = 0; s < header->symbols_num; s++)
+            {
+                const OrderCache::Entry& entry = entries[s];
+                SymbolId symbol = symbol_dictionary.intern(name(entry.name_offset, entry.name_length));
+                std::size_t rows = entry.rows;
+                const char* block = file.data() + entry.offset;
+                const std::int64_t* times = reinterpret_cast<const std::int64_t*>(block);
+                const std::int64_t* bid_prices = times + rows;
+                const std::int64_t* ask_prices = bid_prices + rows;
+                const std::int64_t* trade_prices = ask_prices + rows;
+                const std::uint32_t* bid_volumes = reinterpret_cast<const std::uint32_t*>(trade_prices + rows);
+                const std::uint32_t* ask_volumes = bid_volumes + rows;
+                const std::uint32_t* trade_volumes = ask_volumes + rows;
+                const std::uint32_t* dates = trade_volumes + rows;
+                const ConditionId* condition_codes = reinterpret_cast<const ConditionId*>(dates + rows);
+                const std::uint8_t* types = reinterpret_cast<const std::uint8_t*>(condition_codes + rows);
+                for (std::size_t i = 0; i < rows; i++)
+                {
+                    ConditionId condition = condition_codes[i] < condition_ids.size() ? condition_ids[condition_codes[i]] : 0;
+                    sink(Order(symbol, bid_prices[i], ask_prices[i], trade_prices[i],
+                               bid_volumes[i], ask_volumes[i], trade_volumes[i], condition,
+                               static_cast<UpdateType>(types[i]), dates[i], times[i]));
+                }
+            }
+        }
+};
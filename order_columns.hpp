@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "order.hpp"
+
+class OrderColumns
+{
+    /* Struct-of-arrays storage of the orders of one symbol: every field is kept in its own contiguous column.
+    OrderCache writes the columns to disk as they are, and a scan which needs one or two fields
+    (e.g. spread_sum) reads only those columns in a loop the compiler can vectorize, instead of
+    striding over whole Order records. The statistics of the book are computed by analyze() as the orders arrive.
+    The symbol is not stored, all rows belong to the symbol of the book.
+    */
+    private:
+        std::vector<std::int64_t> times;        // nanoseconds since the epoch
+        std::vector<std::int64_t> bid_prices;   // ticks
+        std::vector<std::int64_t> ask_prices;   // ticks
+        std::vector<std::int64_t> trade_prices; // ticks
+        std::vector<std::uint32_t> bid_volumes;
+        std::vector<std::uint32_t> ask_volumes;
+        std::vector<std::uint32_t> trade_volumes;
+        std::vector<std::uint32_t> dates;       // yyyymmdd
+        std::vector<ConditionId> conditions;
+        std::vector<std::uint8_t> types;        // UpdateType
+
+    public:
+        void push_back(const Order& order)
+        {
+            times.push_back(order.getTime());
+            bid_prices.push_back(order.getBidTicks());
+            ask_prices.push_back(order.getAskTicks());
+            trade_prices.push_back(order.getTradeTicks());
+            bid_volumes.push_back(order.getBidVolume());
+            ask_volumes.push_back(order.getAskVolume());
+            trade_volumes.push_back(order.getTradeVolume());
+            dates.push_back(order.getDate());
+            conditions.push_back(order.getConditionId());
+            types.push_back(static_cast<std::uint8_t>(order.getType()));
+        }
+
+        Order row(std::size_t index, SymbolId symbol) const
+        {
+            return Order(symbol, bid_prices[index], ask_prices[index], trade_prices[index],
+                         bid_volumes[index], ask_volumes[index], trade_volumes[index], conditions[index],
+                         static_cast<UpdateType>(types[index]), dates[index], times[index]);
+        }
+
+        void append(const OrderColumns& other)
+        {
+            times.insert(times.end(), other.times.begin(), other.times.end());
+            bid_prices.insert(bid_prices.end(), other.bid_prices.begin(), other.bid_prices.end());
+            ask_prices.insert(ask_prices.end(), other.ask_prices.begin(), other.ask_prices.end());
+            trade_prices.insert(trade_prices.end(), other.trade_prices.begin(), other.trade_prices.end());
+            bid_volumes.insert(bid_volumes.end(), other.bid_volumes.begin(), other.bid_volumes.end());
+            ask_volumes.insert(ask_volumes.end(), other.ask_volumes.begin(), other.ask_volumes.end());
+            trade_volumes.insert(trade_volumes.end(), other.trade_volumes.begin(), other.trade_volumes.end());
+            dates.insert(dates.end(), other.dates.begin(), other.dates.end());
+            conditions.insert(conditions.end(), other.conditions.begin(), other.conditions.end());
+            types.insert(types.end(), other.types.begin(), other.types.end());
+        }
+
+        std::size_t size() const { return times.size(); }
+
+        bool empty() const { return times.empty(); }
+
+        const std::vector<std::int64_t>& get_times() const { return times; }
+        const std::vector<std::int64_t>& get_bid_prices() const { return bid_prices; }
+        const std::vector<std::int64_t>& get_ask_prices() const { return ask_prices; }
+        const std::vector<std::int64_t>& get_trade_prices() const { return trade_prices; }
+        const std::vector<std::uint32_t>& get_bid_volumes() const { return bid_volumes; }
+        const std::vector<std::uint32_t>& get_ask_volumes() const { return ask_volumes; }
+        const std::vector<std::uint32_t>& get_trade_volumes() const { return trade_volumes; }
+        const std::vector<std::uint32_t>& get_dates() const { return dates; }
+        const std::vector<ConditionId>& get_conditions() const { return conditions; }
+        const std::vector<std::uint8_t>& get_types() const { return types; }
+
+        std::int64_t spread_sum() const
+        {
+            std::int64_t sum = 0;
+            const std::int64_t* ask = ask_prices.data();
+            const std::int64_t* bid = bid_prices.data();
+            for (std::size_t i = 0; i < size(); i++)
+            {
+                sum += ask[i] - bid[i];
+            }
+            return sum;
+        }
+};
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "order.hpp"
+#include "spsc_queue.hpp"
+
+class OrderMerger
+{
+    /* Merges the order streams of several sources (e.g. one file per exchange or day) by the timestamp.
+    Every source is read on its own thread, which parses its orders into batches of batch_size orders.
+    The batches travel through two SpscQueues per source: the filled ones to the merging thread,
+    the consumed ones back to the reader, so the memory is bounded by batches_num batches per source
+    and the I/O and the parsing of the sources overlap.
+    The merging thread keeps the current order of every source in a binary min-heap of cursors ordered by
+    (time, source index) and passes the orders to the sink one at a time: within a source the orders keep
+    the order of the source, equal times of different sources go in the order of the sources.
+    If every source is sorted by time, the merged stream is sorted by time as well.
+    */
+    public:
+        static constexpr std::size_t batch_size = 4096; // orders per batch
+        static constexpr std::size_t batches_num = 8;   // batches per source
+
+    private:
+        struct Source
+        {
+            SpscQueue<std::vector<Order>> filled; // reader -> merger
+            SpscQueue<std::vector<Order>> spare;  // merger -> reader
+            std::atomic<bool> done{false};
+            std::thread reader;
+            Source(): filled(batches_num), spare(batches_num)
+            {
+                for (std::size_t i = 1; i < batches_num; i++) // the reader holds one more batch
+                {
+                    std::vector<Order> batch;
+                    batch.reserve(batch_size);
+                    spare.try_push(std::move(batch));
+                }
+            }
+        };
+
+        struct Cursor
+        {
+            /* Position of the merge in the current batch of a source */
+            std::size_t source;
+            std::vector<Order> batch;
+            std::size_t position = 0;
+            bool taken = false; // the batch came from the queue and has to be returned to the reader
+            const Order& order() const { return batch[position]; }
+        };
+
+        std::vector<std::unique_ptr<Source>> sources;
+        std::atomic<bool> stopping{false};
+
+        static void wait(unsigned int& idle)
+        {
+            /* Back-off of a thread polling an empty queue, as ShardedOrderTable::consume */
+            if (++idle < 64)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        bool next_batch(Cursor& cursor)
+        {
+            /* Returns the consumed batch to the reader and waits for the next one.
+            :returns false at the end of the source
+            */
+            Source& source = *sources[cursor.source];
+            if (cursor.taken)
+            {
+                cursor.batch.clear();
+                source.spare.try_push(std::move(cursor.batch));
+                cursor.batch = std::vector<Order>();
+                cursor.taken = false;
+            }
+            unsigned int idle = 0;
+            while (true)
+            {
+                std::vector<Order>* batch = source.filled.front();
+                if (batch != nullptr)
+                {
+                    cursor.batch.swap(*batch);
+                    source.filled.pop();
+                    cursor.taken = true;
+                    cursor.position = 0;
+                    if (!cursor.batch.empty())
+                    {
+                        return true;
+                    }
+                    continue;
+                }
+                if (source.done.load(std::memory_order_acquire))
+                {
+                    if (source.filled.front() == nullptr) // the batches published before "done" are visible now
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+                wait(idle);
+            }
+        }
+
+        static bool later(const Cursor& a, const Cursor& b)
+        {
+            std::int64_t a_time = a.order().getTime();
+            std::int64_t b_time = b.order().getTime();
+            return a_time > b_time || (a_time == b_time && a.source > b.source);
+        }
+
+        static void sift_down(std::vector<Cursor*>& heap, std::size_t index)
+        {
+            /* Restores the heap below "index" after its cursor has advanced */
+            std::size_t size = heap.size();
+            while (true)
+            {
+                std::size_t smallest = index;
+                std::size_t left = 2 * index + 1;
+                std::size_t right = left + 1;
+                if (left < size && later(*heap[smallest], *heap[left]))
+                {
+                    smallest = left;
+                }
+                if (right < size && later(*heap[smallest], *heap[right]))
+                {
+                    smallest = right;
+                }
+                if (smallest == index)
+                {
+                    return;
+                }
+                std::swap(heap[index], heap[smallest]);
+                index = smallest;
+            }
+        }
+
+    public:
+        class Output
+        {
+            /* Reader side of a source: collects the parsed orders into batches and publishes the full ones */
+            private:
+                Source& source;
+                const std::atomic<bool>& stopping;
+                std::vector<Order> batch;
+
+            public:
+                Output(Source& source, const std::atomic<bool>& stopping): source{source}, stopping{stopping}
+                {
+                    batch.reserve(batch_size);
+                }
+
+                void push(const Order& order)
+                {
+                    batch.push_back(order);
+                    if (batch.size() == batch_size)
+                    {
+                        flush();
+                    }
+                }
+
+                void flush()
+                {
+                    /* Publishes the collected orders and takes an empty batch, waits while the merger is behind */
+                    if (batch.empty())
+                    {
+                        return;
+                    }
+                    unsigned int idle = 0;
+                    while (!source.filled.try_push(std::move(batch)))
+                    {
+                        if (stopping.load(std::memory_order_relaxed))
+                        {
+                            batch.clear();
+                            return;
+                        }
+                        wait(idle);
+                    }
+                    batch = std::vector<Order>();
+                    idle = 0;
+                    while (true)
+                    {
+                        std::vector<Order>* spare = source.spare.front();
+                        if (spare != nullptr)
+                        {
+                            batch.swap(*spare);
+                            source.spare.pop();
+                            return;
+                        }
+                        if (stopping.load(std::memory_order_relaxed))
+                        {
+                            return; // the merger is gone, the remaining orders are dropped by the next flush
+                        }
+                        wait(idle);
+                    }
+                }
+        };
+
+        template <typename Read>
+        OrderMerger(std::size_t sources_num, Read read)
+        {
+            /* :param read(index, output) parses the source "index" into output.push(order), on the thread of the source */
+            for (std::size_t i = 0; i < sources_num; i++)
+            {
+                sources.emplace_back(new Source());
+            }
+            for (std::size_t i = 0; i < sources_num; i++)
+            {
+                Source* source = sources[i].get();
+                source->reader = std::thread([this, source, i, read]()
+                {
+                    Output output(*source, stopping);
+                    read(i, output);
+                    output.flush();
+                    source->done.store(true, std::memory_order_release);
+                });
+            }
+        }
+
+        OrderMerger(const OrderMerger&) = delete;
+        OrderMerger& operator=(const OrderMerger&) = delete;
+
+        ~OrderMerger()
+        {
+            /* A reader still waiting for the merger (merge() was not called or did not finish) stops waiting */
+            stopping.store(true, std::memory_order_relaxed);
+            for (auto& source : sources)
+            {
+                source->reader.join();
+            }
+        }
+
+        template <typename Sink>
+        void merge(Sink sink, std::size_t limit = 0)
+        {
+            /* Passes the orders of all sources to sink(order) in the order of their timestamps, on the calling thread
+            :param limit is the maximum number of orders passed, 0 means all
+            */
+            std::size_t passed = 0;
+            std::vector<Cursor> cursors(sources.size());
+            std::vector<Cursor*> heap;
+            for (std::size_t i = 0; i < sources.size(); i++)
+            {
+                cursors[i].source = i;
+                if (next_batch(cursors[i]))
+                {
+                    heap.push_back(&cursors[i]);
+                }
+            }
+            for (std::size_t i = heap.size() / 2; i-- > 0;)
+            {
+                sift_down(heap, i);
+            }
+            while (!heap.empty())
+            {
+                Cursor& cursor = *heap.front();
+                sink(cursor.order());
+                if (++passed == limit)
+                {
+                    return; // the readers still running are stopped by the destructor
+                }
+                if (++cursor.position == cursor.batch.size() && !next_batch(cursor))
+                {
+                    heap.front() = heap.back(); // the source is exhausted
+                    heap.pop_back();
+                }
+                if (!heap.empty())
+                {
+                    sift_down(heap, 0);
+                }
+            }
+        }
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "binary_io.hpp"
+
+class SketchStore
+{
+    /* Contiguous range of logarithmic buckets of a QuantileSketch.
+    counts[i] holds the number of values which fell into the bucket with key (offset + i).
+    When the range grows beyond max_bins the lowest buckets are collapsed into one,
+    which bounds the memory while keeping the accuracy of the upper quantiles.
+    */
+    private:
+        std::vector<std::uint64_t> counts;
+        int offset;
+        std::size_t max_bins;
+        std::uint64_t total;
+
+        void extend(int key)
+        {
+            if (counts.empty())
+            {
+                counts.assign(1, 0);
+                offset = key;
+                return;
+            }
+            if (key < offset)
+            {
+                counts.insert(counts.begin(), static_cast<std::size_t>(offset - key), 0);
+                offset = key;
+            }
+            else if (key >= offset + static_cast<int>(counts.size()))
+            {
+                counts.resize(static_cast<std::size_t>(key - offset) + 1, 0);
+            }
+            collapse();
+        }
+
+        void collapse()
+        {
+            if (counts.size() <= max_bins)
+            {
+                return;
+            }
+            std::size_t excess = counts.size() - max_bins;
+            std::uint64_t collapsed = 0;
+            for (std::size_t i = 0; i <= excess; i++)
+            {
+                collapsed += counts[i];
+            }
+            counts.erase(counts.begin(), counts.begin() + excess);
+            counts[0] = collapsed;
+            offset += static_cast<int>(excess);
+        }
+
+    public:
+        SketchStore(std::size_t max_bins): offset{0}, max_bins{max_bins}, total{0} {}
+
+        void add(int key, std::uint64_t count = 1)
+        {
+            if (!counts.empty() && key < offset && counts.size() == max_bins)
+            {
+                key = offset; // already collapsed range
+            }
+            extend(key);
+            if (key < offset)
+            {
+                key = offset;
+            }
+            counts[static_cast<std::size_t>(key - offset)] += count;
+            total += count;
+        }
+
+        void merge(const SketchStore& other)
+        {
+            for (std::size_t i = 0; i < other.counts.size(); i++)
+            {
+                if (other.counts[i] != 0)
+                {
+                    add(other.offset + static_cast<int>(i), other.counts[i]);
+                }
+            }
+        }
+
+        void save_state(BinaryWriter& out) const
+        {
+            out.write<std::int32_t>(offset);
+            out.write(total);
+            out.write_vector(counts);
+        }
+
+        bool load_state(BinaryReader& in)
+        {
+            std::int32_t saved_offset = 0;
+            if (!in.read(saved_offset) || !in.read(total) || !in.read_vector(counts) || counts.size() > max_bins)
+            {
+                return false;
+            }
+            offset = saved_offset;
+            std::uint64_t sum = 0;
+            for (std::uint64_t count : counts)
+            {
+                sum += count;
+            }
+            return sum == total;
+        }
+
+        int key_at_rank(double rank) const
+        {
+            /* Key of the bucket containing the value of the given (0-based) rank */
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < counts.size(); i++)
+            {
+                cumulative += counts[i];
+                if (static_cast<double>(cumulative) > rank)
+                {
+                    return offset + static_cast<int>(i);
+                }
+            }
+            return offset + static_cast<int>(counts.size()) - 1;
+        }
+
+        std::uint64_t get_count() const { return total; }
+
+        std::size_t get_bins_num() const { return counts.size(); }
+};
+
+class QuantileSketch
+{
+    /* Mergeable quantile sketch with relative error guarantee (DDSketch).
+    Positive values are mapped to the bucket ceil(log_gamma(v)), where gamma = (1 + e) / (1 - e),
+    negative values to a second store by their absolute value and values close to zero to a counter.
+    Any quantile is returned with a relative error of at most "relative_error",
+    while memory is bounded by 2 * max_bins buckets no matter how many values are added.
+    Sketches created with the same error bound can be merged without loss of accuracy.
+    */
+    private:
+        double relative_error;
+        double gamma;
+        double log_gamma;
+        double min_indexable; // values with smaller magnitude are counted as zeros
+        SketchStore positive;
+        SketchStore negative;
+        std::uint64_t zero_count;
+
+        int key(double value) const
+        {
+            return static_cast<int>(std::ceil(std::log(value) / log_gamma));
+        }
+
+        double value(int key) const
+        {
+            return 2.0 * std::pow(gamma, key) / (gamma + 1.0);
+        }
+
+    public:
+        QuantileSketch(double relative_error = 0.01, std::size_t max_bins = 2048):
+            relative_error{relative_error},
+            gamma{(1.0 + relative_error) / (1.0 - relative_error)},
+            log_gamma{std::log((1.0 + relative_error) / (1.0 - relative_error))},
+            min_indexable{1e-9},
+            positive(max_bins),
+            negative(max_bins),
+            zero_count{0}
+        {
+            if (!(relative_error > 0.0 && relative_error < 1.0))
+            {
+                throw std::invalid_argument("QuantileSketch: relative error must be within (0, 1)");
+            }
+        }
+
+        void add(double v)
+        {
+            if (v > min_indexable)
+            {
+                positive.add(key(v));
+            }
+            else if (v < -min_indexable)
+            {
+                negative.add(key(-v));
+            }
+            else
+            {
+                zero_count++;
+            }
+        }
+
+        void merge(const QuantileSketch& other)
+        {
+            if (other.relative_error != relative_error)
+            {
+                throw std::invalid_argument("QuantileSketch: cannot merge sketches with different error bounds");
+            }
+            positive.merge(other.positive);
+            negative.merge(other.negative);
+            zero_count += other.zero_count;
+        }
+
+        void save_state(BinaryWriter& out) const
+        {
+            /* The buckets only, the error bound is a setting of the sketch */
+            out.write(zero_count);
+            positive.save_state(out);
+            negative.save_state(out);
+        }
+
+        bool load_state(BinaryReader& in)
+        {
+            return in.read(zero_count) && positive.load_state(in) && negative.load_state(in);
+        }
+
+        std::uint64_t get_count() const
+        {
+            return positive.get_count() + negative.get_count() + zero_count;
+        }
+
+        bool empty() const { return get_count() == 0; }
+
+        double get_relative_error() const { return relative_error; }
+
+        std::size_t get_bins_num() const { return positive.get_bins_num() + negative.get_bins_num(); }
+
+        double quantile(double q) const
+        {
+            /* :param q is within [0, 1], e.g. 0.5 for the median and 0.99 for p99
+            :returns approximate value of the quantile or 0.0 if the sketch is empty
+            */
+            std::uint64_t count = get_count();
+            if (count == 0)
+            {
+                return 0.0;
+            }
+            q = std::min(std::max(q, 0.0), 1.0);
+            double rank = q * static_cast<double>(count - 1);
+
+            double negative_count = static_cast<double>(negative.get_count());
+            if (rank < negative_count)
+            {
+                // the most negative values have the largest keys
+                return -value(negative.key_at_rank(negative_count - 1 - rank));
+            }
+            if (rank < negative_count + static_cast<double>(zero_count))
+            {
+                return 0.0;
+            }
+            return value(positive.key_at_rank(rank - negative_count - static_cast<double>(zero_count)));
+        }
+};
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <iterator>
+#include "binary_io.hpp"
+
+template <typename T>
+class RingBuffer
+{
+    /* FIFO over a contiguous array with a fixed maximum capacity, push_back and pop_front are O(1).
+    The array grows by doubling until it reaches the capacity, so an idle buffer takes little memory,
+    once the capacity is reached the buffer never allocates again.
+    */
+    private:
+        std::vector<T> items;
+        std::size_t limit;
+        std::size_t head = 0;  // index of the oldest element
+        std::size_t count = 0;
+
+        void grow()
+        {
+            std::vector<T> larger(std::min(std::max<std::size_t>(16, 2 * items.size()), limit));
+            for (std::size_t i = 0; i < count; i++)
+            {
+                larger[i] = (*this)[i];
+            }
+            items.swap(larger);
+            head = 0;
+        }
+
+    public:
+        explicit RingBuffer(std::size_t capacity = 0): limit{capacity} {}
+
+        std::size_t capacity() const { return limit; }
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        bool full() const { return count == limit; }
+
+        const T& front() const { return items[head]; }
+        const T& operator[](std::size_t index) const { return items[(head + index) % items.size()]; }
+
+        void push_back(const T& item)
+        {
+            /* The buffer must not be full */
+            if (count == items.size())
+            {
+                grow();
+            }
+            items[(head + count) % items.size()] = item;
+            count++;
+        }
+
+        void pop_front()
+        {
+            head = (head + 1) % items.size();
+            count--;
+        }
+};
+
+template <typename T>
+class WindowMedian
+{
+    /* Median of a multiset which supports removal: the smaller half is kept in "lower" and the larger one
+    in "upper" (lower has the same number of elements or one more), insert and erase are O(log n)
+    */
+    private:
+        std::multiset<T> lower;
+        std::multiset<T> upper;
+
+        void rebalance()
+        {
+            if (lower.size() > upper.size() + 1)
+            {
+                auto largest = std::prev(lower.end());
+                upper.insert(*largest);
+                lower.erase(largest);
+            }
+            else if (upper.size() > lower.size())
+            {
+                auto smallest = upper.begin();
+                lower.insert(*smallest);
+                upper.erase(smallest);
+            }
+        }
+
+    public:
+        void insert(T value)
+        {
+            if (lower.empty() || value <= *lower.rbegin())
+            {
+                lower.insert(value);
+            }
+            else
+            {
+                upper.insert(value);
+            }
+            rebalance();
+        }
+
+        void erase(T value)
+        {
+            /* Removes one element equal to the value, the value must be present */
+            if (!lower.empty() && value <= *lower.rbegin())
+            {
+                lower.erase(lower.find(value));
+            }
+            else
+            {
+                upper.erase(upper.find(value));
+            }
+            rebalance();
+        }
+
+        std::size_t size() const { return lower.size() + upper.size(); }
+
+        double median() const
+        {
+            /* Average of the two middle elements for an even number of elements, as RunningMedian::median */
+            if (lower.empty())
+            {
+                return 0.0;
+            }
+            if (lower.size() == upper.size())
+            {
+                return static_cast<double>(*lower.rbegin() + *upper.begin()) / 2;
+            }
+            return static_cast<double>(*lower.rbegin());
+        }
+};
+
+template <typename T>
+class RollingWindow
+{
+    /* Values of the events within the last "duration" nanoseconds of event time.
+    The events are kept in a ring buffer in time order, so the expired ones are evicted from its front,
+    the sum and the WindowMedian are updated on every insertion and eviction.
+    If more than "capacity" events fall within the duration, the oldest ones are evicted early
+    and the window covers the last "capacity" events only, such evictions are counted by get_truncated().
+    The window ends at the latest event (or advance) time, its statistics cannot be read at an earlier time:
+    the evicted events are gone, use TimeIndex for the point-in-time queries.
+    */
+    private:
+        std::int64_t duration;
+        RingBuffer<std::pair<std::int64_t, T>> events; // (time, value)
+        WindowMedian<T> middle;
+        T sum = T();
+        std::uint64_t truncated = 0; // events evicted by the capacity while still within the duration
+
+        void evict_front()
+        {
+            const std::pair<std::int64_t, T>& oldest = events.front();
+            sum -= oldest.second;
+            middle.erase(oldest.second);
+            events.pop_front();
+        }
+
+    public:
+        RollingWindow(std::int64_t duration, std::size_t capacity): duration{duration}, events(capacity) {}
+
+        void advance(std::int64_t now)
+        {
+            /* Evict the events which are older than now - duration */
+            while (!events.empty() && events.front().first <= now - duration)
+            {
+                evict_front();
+            }
+        }
+
+        void add(std::int64_t time, T value)
+        {
+            advance(time);
+            if (events.capacity() == 0)
+            {
+                return;
+            }
+            if (events.full())
+            {
+                evict_front();
+                truncated++;
+            }
+            events.push_back(std::make_pair(time, value));
+            middle.insert(value);
+            sum += value;
+        }
+
+        void merge(const RollingWindow& other)
+        {
+            /* Append the events of the other window, which must be later in time */
+            for (std::size_t i = 0; i < other.events.size(); i++)
+            {
+                add(other.events[i].first, other.events[i].second);
+            }
+            truncated += other.truncated;
+        }
+
+        void save_state(BinaryWriter& out) const
+        {
+            /* The events in the window, oldest first, and the truncation count */
+            out.write<std::uint64_t>(events.size());
+            for (std::size_t i = 0; i < events.size(); i++)
+            {
+                out.write(events[i].first);
+                out.write(events[i].second);
+            }
+            out.write(truncated);
+        }
+
+        bool load_state(BinaryReader& in)
+        {
+            /* Into an empty window of the same duration and capacity, the events are added again in time order */
+            std::uint64_t size = 0;
+            if (!in.read(size) || size > events.capacity())
+            {
+                return false;
+            }
+            for (std::uint64_t i = 0; i < size; i++)
+            {
+                std::int64_t time;
+                T value;
+                if (!in.read(time) || !in.read(value))
+                {
+                    return false;
+                }
+                add(time, value);
+            }
+            return in.read(truncated) && events.size() == size;
+        }
+
+        std::int64_t get_duration() const { return duration; }
+        std::size_t size() const { return events.size(); }
+        bool empty() const { return events.empty(); }
+        std::uint64_t get_truncated() const { return truncated; }
+
+        double mean() const
+        {
+            return empty() ? 0.0 : static_cast<double>(sum) / static_cast<double>(events.size());
+        }
+
+        double median() const { return middle.median(); }
+};
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include "binary_io.hpp"
+
+// the digit counting uses _mm_cvtsi128_si64, which exists on x86-64 only (ORDERBOOK_X86 includes i386)
+#if defined(__x86_64__) || defined(_M_X64)
+#define ORDERBOOK_X86_64 1
+#include <immintrin.h>
+#endif
+
+class DigitHistogram
+{
+    /* Distribution of the last digits of a set of values.
+    The round number effect shows up as an excess of the digit 0 (and 5) over the uniform distribution,
+    the chi-square statistic against the uniform distribution (9 degrees of freedom) measures its significance.
+    */
+    private:
+        std::array<std::uint64_t, 10> counts{};
+
+        static double upper_gamma_series(double a, double x)
+        {
+            double sum = 1.0 / a;
+            double term = sum;
+            for (int n = 1; n < 1000; n++)
+            {
+                term *= x / (a + n);
+                sum += term;
+                if (std::fabs(term) < std::fabs(sum) * 1e-15)
+                {
+                    break;
+                }
+            }
+            return 1.0 - sum * std::exp(-x + a * std::log(x) - std::lgamma(a));
+        }
+
+        static double upper_gamma_fraction(double a, double x)
+        {
+            // modified Lentz's method for the continued fraction of Q(a, x)
+            const double tiny = 1e-300;
+            double b = x + 1.0 - a;
+            double c = 1.0 / tiny;
+            double d = 1.0 / b;
+            double h = d;
+            for (int i = 1; i < 1000; i++)
+            {
+                double an = -i * (i - a);
+                b += 2.0;
+                d = an * d + b;
+                if (std::fabs(d) < tiny) { d = tiny; }
+                c = b + an / c;
+                if (std::fabs(c) < tiny) { c = tiny; }
+                d = 1.0 / d;
+                double delta = d * c;
+                h *= delta;
+                if (std::fabs(delta - 1.0) < 1e-15)
+                {
+                    break;
+                }
+            }
+            return std::exp(-x + a * std::log(x) - std::lgamma(a)) * h;
+        }
+
+    public:
+        void add(unsigned int digit, std::uint64_t count = 1) { counts[digit] += count; }
+
+        void merge(const DigitHistogram& other)
+        {
+            for (std::size_t d = 0; d < counts.size(); d++)
+            {
+                counts[d] += other.counts[d];
+            }
+        }
+
+        std::uint64_t get_count(unsigned int digit) const { return counts[digit]; }
+
+        std::uint64_t total() const
+        {
+            std::uint64_t sum = 0;
+            for (std::uint64_t count : counts)
+            {
+                sum += count;
+            }
+            return sum;
+        }
+
+        double share(unsigned int digit) const
+        {
+            std::uint64_t all = total();
+            return all == 0 ? 0.0 : static_cast<double>(counts[digit]) / static_cast<double>(all);
+        }
+
+        double chi_square() const
+        {
+            /* Pearson's statistic against the uniform distribution of the digits */
+            std::uint64_t all = total();
+            if (all == 0)
+            {
+                return 0.0;
+            }
+            double expected = static_cast<double>(all) / counts.size();
+            double statistic = 0.0;
+            for (std::uint64_t count : counts)
+            {
+                double difference = static_cast<double>(count) - expected;
+                statistic += difference * difference / expected;
+            }
+            return statistic;
+        }
+
+        double p_value() const
+        {
+            /* Probability of a chi-square at least this large if the digits were uniform (9 degrees of freedom),
+            i.e. the regularized upper incomplete gamma function Q(9 / 2, chi_square / 2)
+            */
+            double x = chi_square() / 2.0;
+            const double a = 4.5;
+            if (x <= 0.0)
+            {
+                return 1.0;
+            }
+            return x < a + 1.0 ? upper_gamma_series(a, x) : upper_gamma_fraction(a, x);
+        }
+};
+
+class DigitKernel
+{
+    /* Batch computation of the last-digit histograms.
+    The digits of a batch are computed into a byte buffer first and counted per digit afterwards,
+    the digits are computed by a loop without dependencies between the iterations (32-bit division by a constant,
+    vectorized by the compiler) and counted with SSE2 byte compares, 16 digits per instruction.
+    Batches with values beyond 32 bits take the scalar 64-bit path.
+    */
+    public:
+        static constexpr std::size_t batch_size = 1024;
+
+        static void count_digits(const std::uint8_t* digits, std::size_t size, DigitHistogram& histogram)
+        {
+            std::size_t vector_end = 0;
+#ifdef ORDERBOOK_X86_64
+            // 16 byte compares per step, the matches are accumulated in byte lanes (at most 255 steps)
+            // and summed up by _mm_sad_epu8
+            vector_end = size - size % 16;
+            const __m128i zero = _mm_setzero_si128();
+            std::uint64_t counts[10];
+            for (unsigned int d = 0; d < 10; d++)
+            {
+                const __m128i target = _mm_set1_epi8(static_cast<char>(d));
+                __m128i total = zero;
+                for (std::size_t begin = 0; begin < vector_end; begin += 16 * 255)
+                {
+                    std::size_t end = std::min(vector_end, begin + 16 * 255);
+                    __m128i lanes = zero;
+                    for (std::size_t i = begin; i < end; i += 16)
+                    {
+                        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits + i));
+                        lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(chunk, target));
+                    }
+                    total = _mm_add_epi64(total, _mm_sad_epu8(lanes, zero));
+                }
+                counts[d] = static_cast<std::uint64_t>(_mm_cvtsi128_si64(total))
+                          + static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(total, total)));
+            }
+            for (unsigned int d = 0; d < 10; d++)
+            {
+                histogram.add(d, counts[d]);
+            }
+#endif
+            for (std::size_t i = vector_end; i < size; i++)
+            {
+                histogram.add(digits[i]);
+            }
+        }
+
+        template <std::int64_t Divisor>
+        static void price_batch(const std::int64_t* batch, std::size_t count, std::uint8_t* digits)
+        {
+            std::uint32_t values[batch_size];
+            std::uint64_t high = 0; // the upper halves of the magnitudes or-ed together
+            for (std::size_t i = 0; i < count; i++)
+            {
+                // branch-free absolute value with shifts only, so the loop vectorizes with plain SSE2
+                std::uint64_t value = static_cast<std::uint64_t>(batch[i]);
+                std::uint64_t sign = 0 - (value >> 63);
+                std::uint64_t magnitude = (value ^ sign) - sign;
+                high |= magnitude >> 32;
+                values[i] = static_cast<std::uint32_t>(magnitude);
+            }
+            if (high == 0)
+            {
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    digits[i] = static_cast<std::uint8_t>(values[i] / static_cast<std::uint32_t>(Divisor) % 10);
+                }
+                return;
+            }
+            for (std::size_t i = 0; i < count; i++)
+            {
+                std::int64_t value = batch[i] < 0 ? -batch[i] : batch[i];
+                digits[i] = static_cast<std::uint8_t>(value / Divisor % 10);
+            }
+        }
+
+        static void price_digits(const std::int64_t* ticks, std::size_t size, std::int64_t divisor, DigitHistogram& histogram)
+        {
+            /* Last digit of |ticks| / divisor, e.g. the cents digit of prices in ticks of 1/10000 for divisor 100.
+            The divisor is a power of ten up to Order::price_scale, each one has its own kernel,
+            so the divisions are by constants
+            */
+            std::uint8_t digits[batch_size];
+            for (std::size_t begin = 0; begin < size; begin += batch_size)
+            {
+                std::size_t count = std::min(batch_size, size - begin);
+                const std::int64_t* batch = ticks + begin;
+                switch (divisor)
+                {
+                    case 1:     price_batch<1>(batch, count, digits); break;
+                    case 10:    price_batch<10>(batch, count, digits); break;
+                    case 100:   price_batch<100>(batch, count, digits); break;
+                    case 1000:  price_batch<1000>(batch, count, digits); break;
+                    default:    price_batch<10000>(batch, count, digits); break;
+                }
+                count_digits(digits, count, histogram);
+            }
+        }
+
+        static void volume_digits(const std::uint32_t* volumes, std::size_t size, DigitHistogram& histogram)
+        {
+            std::uint8_t digits[batch_size];
+            for (std::size_t begin = 0; begin < size; begin += batch_size)
+            {
+                std::size_t count = std::min(batch_size, size - begin);
+                const std::uint32_t* batch = volumes + begin;
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    digits[i] = static_cast<std::uint8_t>(batch[i] % 10);
+                }
+                count_digits(digits, count, histogram);
+            }
+        }
+};
+
+class RoundNumberStats
+{
+    /* Last-digit histograms of the trade prices and the trade volumes of one book.
+    The trades are buffered and passed to DigitKernel a batch at a time, the buffer is counted on demand
+    by the const getters, so the results are always up to date.
+    */
+    private:
+        std::int64_t divisor;               // ticks per unit of the examined digit
+        std::vector<std::int64_t> prices;   // pending trade prices (ticks)
+        std::vector<std::uint32_t> volumes; // pending trade volumes
+        DigitHistogram price_histogram;
+        DigitHistogram volume_histogram;
+
+        void flush()
+        {
+            DigitKernel::price_digits(prices.data(), prices.size(), divisor, price_histogram);
+            DigitKernel::volume_digits(volumes.data(), volumes.size(), volume_histogram);
+            prices.clear();
+            volumes.clear();
+        }
+
+    public:
+        explicit RoundNumberStats(std::int64_t divisor = 100): divisor{divisor < 1 ? 1 : divisor} {}
+
+        void add(std::int64_t price, std::uint32_t volume)
+        {
+            if (prices.empty())
+            {
+                prices.reserve(DigitKernel::batch_size);
+                volumes.reserve(DigitKernel::batch_size);
+            }
+            prices.push_back(price);
+            volumes.push_back(volume);
+            if (prices.size() == DigitKernel::batch_size)
+            {
+                flush();
+            }
+        }
+
+        void merge(const RoundNumberStats& other)
+        {
+            price_histogram.merge(other.get_price_digits());
+            volume_histogram.merge(other.get_volume_digits());
+        }
+
+        void save_state(BinaryWriter& out) const
+        {
+            /* The histograms with the pending trades counted in */
+            DigitHistogram prices_digits = get_price_digits();
+            DigitHistogram volumes_digits = get_volume_digits();
+            for (unsigned int d = 0; d < 10; d++)
+            {
+                out.write(prices_digits.get_count(d));
+            }
+            for (unsigned int d = 0; d < 10; d++)
+            {
+                out.write(volumes_digits.get_count(d));
+            }
+        }
+
+        bool load_state(BinaryReader& in)
+        {
+            prices.clear();
+            volumes.clear();
+            price_histogram = DigitHistogram();
+            volume_histogram = DigitHistogram();
+            for (DigitHistogram* histogram : {&price_histogram, &volume_histogram})
+            {
+                for (unsigned int d = 0; d < 10; d++)
+                {
+                    std::uint64_t count = 0;
+                    if (!in.read(count))
+                    {
+                        return false;
+                    }
+                    histogram->add(d, count);
+                }
+            }
+            return true;
+        }
+
+        DigitHistogram get_price_digits() const
+        {
+            DigitHistogram result = price_histogram;
+            DigitKernel::price_digits(prices.data(), prices.size(), divisor, result);
+            return result;
+        }
+
+        DigitHistogram get_volume_digits() const
+        {
+            DigitHistogram result = volume_histogram;
+            DigitKernel::volume_digits(volumes.data(), volumes.size(), result);
+            return result;
+        }
+};
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include "order_book.hpp"
+#include "spsc_queue.hpp"
+
+template <unsigned int Set>
+class BasicShardedOrderTable
+{
+    /* Order table split into a fixed number of shards by the symbol id.
+    Each shard is an OrderTable owned by one worker thread and fed through a lock-free single-producer/single-consumer
+    queue, so the books of different symbols are analysed concurrently and the hot path takes no lock.
+    All orders of a symbol go to the same shard in the order they were submitted, therefore the statistics
+    are identical to a single OrderTable. The producer is the single thread calling processOrder.
+    A shard owns the ids congruent to its index modulo the number of shards and indexes its books by id / shards,
+    so the memory of the books does not grow with the number of shards.
+    The aggregating functions (show_summary, save, ...) may be called only after finish().
+    The shards compute the statistics of the metric set "Set" (Metrics).
+    */
+    public:
+        using Table = BasicOrderTable<Set>;
+        using Book = typename Table::Book;
+
+    private:
+        struct Shard
+        {
+            Table table;
+            SpscQueue<Order> queue;
+            std::thread worker;
+            Shard(const BookOptions& options, std::size_t stride, std::size_t capacity): table(options, stride), queue(capacity) {}
+        };
+
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<bool> done;
+        bool finished;
+
+        void consume(Shard& shard)
+        {
+            unsigned int idle = 0; // consecutive polls of an empty queue
+            while (true)
+            {
+                Order* order = shard.queue.front();
+                if (order != nullptr)
+                {
+                    shard.table.processOrder(*order);
+                    shard.queue.pop();
+                    idle = 0;
+                }
+                else if (done.load(std::memory_order_acquire))
+                {
+                    if (shard.queue.front() == nullptr) // orders pushed before "done" are visible now
+                    {
+                        return;
+                    }
+                }
+                else if (++idle < 64)
+                {
+                    std::this_thread::yield();
+                }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50)); // the producer is idle, back off
+                }
+            }
+        }
+
+        std::vector<const Book*> sorted_books() const
+        {
+            /* Books of all shards ordered by symbol, the same order as in a single OrderTable */
+            std::vector<SymbolId> ids;
+            for (const auto& shard : shards)
+            {
+                std::vector<SymbolId> shard_ids = shard->table.get_symbol_ids();
+                ids.insert(ids.end(), shard_ids.begin(), shard_ids.end());
+            }
+            Table::sort_by_name(ids);
+            std::vector<const Book*> books;
+            for (SymbolId id : ids)
+            {
+                books.push_back(&shards[shard_of(id)]->table.get_book(id));
+            }
+            return books;
+        }
+
+    public:
+        BasicShardedOrderTable(std::size_t shards_num, const BookOptions& options = BookOptions(),
+                               std::size_t queue_capacity = 1 << 14): done{false}, finished{false}
+        {
+            for (std::size_t i = 0; i < std::max<std::size_t>(1, shards_num); i++)
+            {
+                shards.emplace_back(new Shard(options, std::max<std::size_t>(1, shards_num), queue_capacity));
+            }
+            for (auto& shard : shards)
+            {
+                Shard* target = shard.get();
+                shard->worker = std::thread([this, target]() { consume(*target); });
+            }
+        }
+
+        BasicShardedOrderTable(const BasicShardedOrderTable&) = delete;
+        BasicShardedOrderTable& operator=(const BasicShardedOrderTable&) = delete;
+
+        ~BasicShardedOrderTable()
+        {
+            finish();
+        }
+
+        std::size_t getShardsNum() const { return shards.size(); }
+
+        std::vector<const Book*> get_books() const
+        {
+            /* Books of all shards ordered by symbol name, valid after finish() */
+            return sorted_books();
+        }
+
+        std::size_t shard_of(SymbolId symbol) const
+        {
+            return symbol % shards.size(); // the ids are dense, so consecutive symbols go to different shards
+        }
+
+        bool processOrder(const Order& order)
+        {
+            /* Pass the order to the shard of its symbol, waits while the queue of the shard is full.
+            :returns false (the order is dropped) after finish(), the workers do not consume any more
+            */
+            if (done.load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+            Shard& shard = *shards[shard_of(order.getSymbolId())];
+            while (!shard.queue.try_push(order))
+            {
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+        void finish()
+        {
+            /* Wait until all submitted orders are processed and stop the workers */
+            if (finished)
+            {
+                return;
+            }
+            done.store(true, std::memory_order_release);
+            for (auto& shard : shards)
+            {
+                shard->worker.join();
+            }
+            finished = true;
+        }
+
+        const Table& get_shard(std::size_t index) const
+        {
+            return shards[index]->table;
+        }
+
+        int getSymbolsNum() const
+        {
+            int result = 0;
+            for (const auto& shard : shards)
+            {
+                result += shard->table.getSymbolsNum();
+            }
+            return result;
+        }
+
+        int getTotalOrders() const
+        {
+            int result = 0;
+            for (const auto& shard : shards)
+            {
+                result += shard->table.getTotalOrders();
+            }
+            return result;
+        }
+
+        void show_summary() const
+        {
+            std::vector<BookSummary> summaries;
+            std::vector<int> orders;
+            for (const Book* book : sorted_books())
+            {
+                summaries.push_back(book->get_summary());
+                orders.push_back(book->get_orders_num());
+            }
+            Table::show_summary(summaries, orders, getTotalOrders(), getLongestTimeTrades(), getLongestTimeTick());
+        }
+
+        std::vector<BookSummary> get_summaries() const
+        {
+            /* Statistics of the books of all shards in the order of the output, as OrderTable::get_summaries */
+            std::vector<BookSummary> summaries;
+            for (const Book* book : sorted_books())
+            {
+                summaries.push_back(book->get_summary());
+            }
+            return summaries;
+        }
+
+        void save(const std::string& destination_file, SummaryFormat format = SummaryFormat::Text) const
+        {
+            SummaryFormatter::write(destination_file, SummaryFormatter::format<Set>(get_summaries(), format));
+        }
+
+        bool save_checkpoint(const std::string& destination_file) const
+        {
+            /* The books of all shards in one checkpoint, as OrderTable::save_checkpoint, valid after finish() */
+            const BookOptions& options = shards.front()->table.get_options();
+            if (!Checkpoint::write(destination_file, sorted_books(), Table::checkpoint_settings(options)))
+            {
+                std::cerr << "Failed to write the checkpoint: " << destination_file << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        bool load_checkpoint(const std::string& source_file)
+        {
+            /* As OrderTable::load_checkpoint, every book goes to the shard of its symbol.
+            Must be called before the first processOrder, the workers do not touch the tables until then
+            */
+            const BookOptions& options = shards.front()->table.get_options();
+            std::vector<Table> loaded(shards.size(), Table(options, shards.size()));
+            std::string error;
+            if (!Checkpoint::read(source_file, Table::checkpoint_settings(options),
+                                  [this, &loaded](SymbolId symbol, BinaryReader& in) { return loaded[shard_of(symbol)].load_book(symbol, in); },
+                                  error))
+            {
+                std::cerr << "Failed to load the checkpoint: " << source_file << " (" << error << ")" << std::endl;
+                return false;
+            }
+            for (std::size_t i = 0; i < shards.size(); i++)
+            {
+                shards[i]->table = std::move(loaded[i]);
+            }
+            return true;
+        }
+
+        std::pair<std::string, double> getLongestTimeTrades() const
+        {
+            /* Function determines the longest time between trades among all stocks of all shards */
+            std::pair<std::string, double> longestTimeTrades;
+
+            for (const Book* book : sorted_books())
+            {
+                double longestTime = book->get_longest_time_trades();
+                if (longestTime > longestTimeTrades.second)
+                {
+                    longestTimeTrades = { std::string(book->getSymbol()), longestTime };
+                }
+            }
+
+            return longestTimeTrades;
+        }
+
+        std::pair<std::string, double> getLongestTimeTick() const
+        {
+            /* Function determines the longest time between tick among all stocks of all shards */
+            std::pair<std::string, double> longestTimeTick;
+
+            for (const Book* book : sorted_books())
+            {
+                double longestTime = book->get_longest_time_tick();
+                if (longestTime > longestTimeTick.second)
+                {
+                    longestTimeTick = { std::string(book->getSymbol()), longestTime };
+                }
+            }
+
+            return longestTimeTick;
+        }
+};
+
+using ShardedOrderTable = BasicShardedOrderTable<Metrics::All>;
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <filesystem>
+#include "order_book.hpp"
+
+class SnapshotWriter
+{
+    /* Writes the summaries of the order table (OrderTable::save format) on its own thread.
+    Every "interval" the writer raises the due() flag, the ingest thread checks it between the orders,
+    copies the summaries of the books (OrderTable::get_summaries, O(symbols)) and publishes them.
+    The copy is taken between two orders, so every snapshot is a consistent view of the table,
+    the formatting and the file I/O do not stall the ingest.
+    The file is written next to the destination and renamed over it, a reader never sees a partial snapshot.
+    If a new snapshot is published before the previous one is written, only the newest one is written.
+    */
+    public:
+        using Save = void (*)(std::ostream&, const std::vector<BookSummary>&); // columns of the metric set of the table
+
+    private:
+        std::string destination;
+        Save save;
+        std::chrono::milliseconds interval;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<BookSummary> pending;
+        bool has_pending = false;
+        bool stopping = false;
+        std::atomic<bool> requested{false};
+        std::size_t snapshots_num = 0;
+        std::thread worker;
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true)
+            {
+                if (!wake.wait_for(lock, interval, [this]() { return has_pending || stopping; }))
+                {
+                    requested.store(true, std::memory_order_relaxed);
+                    continue;
+                }
+                if (has_pending)
+                {
+                    std::vector<BookSummary> snapshot;
+                    snapshot.swap(pending);
+                    has_pending = false;
+                    lock.unlock();
+                    write(snapshot);
+                    lock.lock();
+                    snapshots_num++;
+                    continue;
+                }
+                return; // stopping and everything has been written
+            }
+        }
+
+        void write(const std::vector<BookSummary>& snapshot) const
+        {
+            std::string temporary = destination + ".tmp";
+            {
+                std::ofstream file(temporary);
+                if (!file)
+                {
+                    std::cerr << "Failed to open file for writing: " << temporary << std::endl;
+                    return;
+                }
+                save(file, snapshot);
+            }
+            std::error_code error;
+            std::filesystem::rename(temporary, destination, error);
+            if (error)
+            {
+                std::cerr << "Failed to write the snapshot: " << destination << std::endl;
+            }
+        }
+
+    public:
+        SnapshotWriter(const std::string& destination, std::chrono::milliseconds interval,
+                       Save save = &OrderTable::save_summaries):
+            destination{destination}, save{save}, interval{interval}
+        {
+            worker = std::thread(&SnapshotWriter::run, this);
+        }
+
+        SnapshotWriter(const SnapshotWriter&) = delete;
+        SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+        ~SnapshotWriter() { stop(); }
+
+        bool due() const
+        {
+            /* Checked by the ingest thread, true if a snapshot should be published */
+            return requested.load(std::memory_order_relaxed);
+        }
+
+        void publish(std::vector<BookSummary>&& snapshot)
+        {
+            requested.store(false, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending = std::move(snapshot);
+                has_pending = true;
+            }
+            wake.notify_one();
+        }
+
+        void stop()
+        {
+            /* Write the last published snapshot and stop the thread */
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            if (worker.joinable())
+            {
+                worker.join();
+            }
+        }
+
+        std::size_t getSnapshotsNum()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return snapshots_num;
+        }
+};
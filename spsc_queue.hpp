@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class SpscQueue
+{
+    /* Bounded lock-free queue for exactly one producer thread and one consumer thread.
+    The elements are constructed in place in a ring buffer, the capacity is rounded up to a power of two.
+    "head" is written only by the consumer and "tail" only by the producer, each side keeps a cached copy
+    of the other index, so the shared cache lines are touched only when the cached value is exhausted.
+    */
+    private:
+        struct Slot
+        {
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        static constexpr std::size_t cache_line = 64;
+
+        std::vector<Slot> slots;
+        std::size_t mask;
+
+        alignas(cache_line) std::atomic<std::size_t> head; // next element to be consumed
+        std::size_t cached_tail;                           // consumer's copy of tail
+
+        alignas(cache_line) std::atomic<std::size_t> tail; // next free slot
+        std::size_t cached_head;                           // producer's copy of head
+
+        T* slot(std::size_t index) { return reinterpret_cast<T*>(slots[index & mask].storage); }
+
+        static std::size_t round_up(std::size_t capacity)
+        {
+            std::size_t result = 2;
+            while (result < capacity)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+    public:
+        explicit SpscQueue(std::size_t capacity):
+            slots(round_up(capacity)), mask{round_up(capacity) - 1}, head{0}, cached_tail{0}, tail{0}, cached_head{0} {}
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        ~SpscQueue()
+        {
+            while (front() != nullptr)
+            {
+                pop();
+            }
+        }
+
+        template <typename... Args>
+        bool try_push(Args&&... args)
+        {
+            /* Producer side. :returns false if the queue is full */
+            std::size_t current = tail.load(std::memory_order_relaxed);
+            if (current - cached_head == slots.size())
+            {
+                cached_head = head.load(std::memory_order_acquire);
+                if (current - cached_head == slots.size())
+                {
+                    return false;
+                }
+            }
+            new (slot(current)) T(std::forward<Args>(args)...);
+            tail.store(current + 1, std::memory_order_release);
+            return true;
+        }
+
+        T* front()
+        {
+            /* Consumer side. :returns the oldest element or nullptr if the queue is empty */
+            std::size_t current = head.load(std::memory_order_relaxed);
+            if (current == cached_tail)
+            {
+                cached_tail = tail.load(std::memory_order_acquire);
+                if (current == cached_tail)
+                {
+                    return nullptr;
+                }
+            }
+            return slot(current);
+        }
+
+        void pop()
+        {
+            /* Consumer side, destroys the element returned by front() */
+            std::size_t current = head.load(std::memory_order_relaxed);
+            slot(current)->~T();
+            head.store(current + 1, std::memory_order_release);
+        }
+
+        std::size_t capacity() const { return slots.size(); }
+};
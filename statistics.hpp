@@ -0,0 +1,304 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <cstddef>
+#include <cmath>
+#include "quantile_sketch.hpp"
+#include "binary_io.hpp"
+
+enum class StatisticsMode
+{
+    Exact,       // every value is retained, medians are exact
+    Approximate, // values are summarised by bounded-memory quantile sketches
+};
+
+template <typename T>
+class RunningMedian
+{
+    /* Median of a stream maintained with two heaps:
+    "lower" is a max-heap holding the smaller half of the values and
+    "upper" is a min-heap holding the larger half.
+    The heaps are kept balanced so that lower.size() is equal to upper.size() or upper.size() + 1,
+    therefore the middle element(s) are always on top of the heaps.
+    Insertion is O(log n), reading the median is O(1).
+    */
+    private:
+        std::vector<T> lower; // max-heap
+        std::vector<T> upper; // min-heap
+
+        void push_lower(T value)
+        {
+            lower.push_back(value);
+            std::push_heap(lower.begin(), lower.end());
+        }
+
+        void push_upper(T value)
+        {
+            upper.push_back(value);
+            std::push_heap(upper.begin(), upper.end(), std::greater<T>());
+        }
+
+        T pop_lower()
+        {
+            std::pop_heap(lower.begin(), lower.end());
+            T value = lower.back();
+            lower.pop_back();
+            return value;
+        }
+
+        T pop_upper()
+        {
+            std::pop_heap(upper.begin(), upper.end(), std::greater<T>());
+            T value = upper.back();
+            upper.pop_back();
+            return value;
+        }
+
+    public:
+        void add(T value)
+        {
+            if (lower.empty() || !(lower.front() < value))
+            {
+                push_lower(value);
+            }
+            else
+            {
+                push_upper(value);
+            }
+
+            // rebalance the heaps
+            if (lower.size() > upper.size() + 1)
+            {
+                push_upper(pop_lower());
+            }
+            else if (upper.size() > lower.size())
+            {
+                push_lower(pop_upper());
+            }
+        }
+
+        std::size_t size() const { return lower.size() + upper.size(); }
+
+        bool empty() const { return lower.empty(); }
+
+        void merge(const RunningMedian& other)
+        {
+            for (T value : other.lower)
+            {
+                add(value);
+            }
+            for (T value : other.upper)
+            {
+                add(value);
+            }
+        }
+
+        double quantile(double q) const
+        {
+            /* Exact quantile with linear interpolation between the closest ranks,
+            for q = 0.5 the result is equal to median().
+            The values are copied and partially sorted, so the call is O(n)
+            */
+            if (empty())
+            {
+                return 0.0;
+            }
+            std::vector<T> values(lower);
+            values.insert(values.end(), upper.begin(), upper.end());
+            q = std::min(std::max(q, 0.0), 1.0);
+            double rank = q * static_cast<double>(values.size() - 1);
+            std::size_t below = static_cast<std::size_t>(std::floor(rank));
+            std::size_t above = static_cast<std::size_t>(std::ceil(rank));
+            std::nth_element(values.begin(), values.begin() + below, values.end());
+            double low = static_cast<double>(values[below]);
+            if (above == below)
+            {
+                return low;
+            }
+            double high = static_cast<double>(*std::min_element(values.begin() + above, values.end()));
+            return low + (high - low) * (rank - static_cast<double>(below));
+        }
+
+        void save_state(BinaryWriter& out) const
+        {
+            /* The heaps as they are, so a loaded median continues exactly as the saved one */
+            out.write_vector(lower);
+            out.write_vector(upper);
+        }
+
+        bool load_state(BinaryReader& in)
+        {
+            if (!in.read_vector(lower) || !in.read_vector(upper))
+            {
+                return false;
+            }
+            return (lower.size() == upper.size() || lower.size() == upper.size() + 1)
+                && std::is_heap(lower.begin(), lower.end())
+                && std::is_heap(upper.begin(), upper.end(), std::greater<T>())
+                && (upper.empty() || !(upper.front() < lower.front()));
+        }
+
+        double median() const
+        {
+            /* Same definition as sorting the values and taking the middle one:
+            for an even number of elements the average of the two middle elements is returned
+            */
+            if (empty())
+            {
+                return 0.0;
+            }
+            if (lower.size() == upper.size())
+            {
+                return static_cast<double>(lower.front() + upper.front()) / 2;
+            }
+            return static_cast<double>(lower.front());
+        }
+};
+
+template <typename T>
+class RunningStats
+{
+    /* Streaming accumulator of count, sum, maximum and median of the values.
+    Every update is O(log n) and every getter is O(1), so the statistics
+    can be refreshed after each order without rescanning the history.
+    For integral T the sum is kept exactly in T.
+    In the approximate mode the values are not retained: the median and other quantiles
+    are answered by a QuantileSketch, so memory does not grow with the number of values.
+    */
+    private:
+        StatisticsMode mode;
+        std::size_t count;
+        T sum;
+        T largest;
+        RunningMedian<T> middle;
+        QuantileSketch sketch;
+
+    public:
+        RunningStats(StatisticsMode mode = StatisticsMode::Exact, double relative_error = 0.01):
+            mode{mode}, count{0}, sum{}, largest{}, sketch(relative_error) {}
+
+        void add(T value)
+        {
+            if (count == 0 || largest < value)
+            {
+                largest = value;
+            }
+            sum += value;
+            count++;
+            if (mode == StatisticsMode::Exact)
+            {
+                middle.add(value);
+            }
+            else
+            {
+                sketch.add(static_cast<double>(value));
+            }
+        }
+
+        void merge(const RunningStats& other)
+        {
+            /* Combine the statistics of two disjoint sets of values (e.g. two shards or two days).
+            Both accumulators must be in the same mode
+            */
+            if (other.mode != mode)
+            {
+                throw std::invalid_argument("RunningStats: cannot merge exact and approximate statistics");
+            }
+            if (other.count == 0)
+            {
+                return;
+            }
+            if (count == 0 || largest < other.largest)
+            {
+                largest = other.largest;
+            }
+            sum += other.sum;
+            count += other.count;
+            if (mode == StatisticsMode::Exact)
+            {
+                middle.merge(other.middle);
+            }
+            else
+            {
+                sketch.merge(other.sketch);
+            }
+        }
+
+        void save_state(BinaryWriter& out) const
+        {
+            /* Exact mode: every value (the heaps of the median), approximate mode: the buckets of the sketch */
+            out.write<std::uint64_t>(count);
+            out.write(sum);
+            out.write(largest);
+            if (mode == StatisticsMode::Exact)
+            {
+                middle.save_state(out);
+            }
+            else
+            {
+                sketch.save_state(out);
+            }
+        }
+
+        bool load_state(BinaryReader& in)
+        {
+            /* The state must have been saved in the same mode (and with the same error bound) */
+            std::uint64_t saved_count = 0;
+            if (!in.read(saved_count) || !in.read(sum) || !in.read(largest))
+            {
+                return false;
+            }
+            count = static_cast<std::size_t>(saved_count);
+            if (mode == StatisticsMode::Exact)
+            {
+                return middle.load_state(in) && middle.size() == count;
+            }
+            return sketch.load_state(in) && sketch.get_count() == count;
+        }
+
+        StatisticsMode get_mode() const { return mode; }
+
+        std::size_t size() const { return count; }
+
+        bool empty() const { return count == 0; }
+
+        double mean() const
+        {
+            if (count == 0)
+            {
+                return 0.0;
+            }
+            return static_cast<double>(sum) / count;
+        }
+
+        double median() const
+        {
+            if (mode == StatisticsMode::Exact)
+            {
+                return middle.median();
+            }
+            return sketch.quantile(0.5);
+        }
+
+        double quantile(double q) const
+        {
+            /* :param q is within [0, 1], e.g. 0.9 for p90 */
+            if (mode == StatisticsMode::Exact)
+            {
+                return middle.quantile(q);
+            }
+            return sketch.quantile(q);
+        }
+
+        double max() const
+        {
+            if (count == 0)
+            {
+                return 0.0;
+            }
+            return static_cast<double>(largest);
+        }
+};
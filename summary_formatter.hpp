@@ -0,0 +1,276 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <charconv>
+#include <algorithm>
+#include <cstddef>
+#include "symbol_dictionary.hpp"
+#include "metrics.hpp"
+
+struct BookSummary
+{
+    /* Copy of the statistics of a book as written by OrderTable::save */
+    SymbolId symbol;
+    double mean_time_trades;
+    double median_time_trades;
+    double longest_time_trades;
+    double mean_time_tick;
+    double median_time_tick;
+    double longest_time_tick;
+    double mean_spread;
+    double median_spread;
+};
+
+enum class SummaryFormat
+{
+    Text, // fixed-width columns of OrderTable::save
+    Csv,  // one line per symbol, the values in the shortest form which reads back to the same double
+};
+
+class SummaryFormatter
+{
+    /* Renders the summary table into memory with std::to_chars instead of the iostream manipulators.
+    The text is identical to the output of std::left, std::setw and std::fixed/std::setprecision:
+    a field shorter than its width is padded with spaces, a longer one is written whole.
+    Large tables are split into ranges of rows which are rendered on several threads into their own
+    preallocated strings and joined in order, the result is written to the file with a single write call.
+    The columns are those of the metric set (Metrics) given as the template argument.
+    */
+    public:
+        static constexpr std::size_t symbol_width = 35;
+        static constexpr std::size_t value_width = 20;
+        static constexpr std::size_t row_width = symbol_width + 8 * value_width + 1; // typical text row with the newline
+        static constexpr std::size_t rows_per_thread = 4096; // smaller tables are rendered by the calling thread
+
+        static void append_padded(std::string& out, std::string_view text, std::size_t width)
+        {
+            out.append(text);
+            if (text.size() < width)
+            {
+                out.append(width - text.size(), ' ');
+            }
+        }
+
+        static void append_fixed(std::string& out, double value, int precision, std::size_t width)
+        {
+            char buffer[512]; // the longest fixed double (1.8e308) with the precision fits
+            std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision);
+            append_padded(out, std::string_view(buffer, result.ptr - buffer), width);
+        }
+
+        static void append_shortest(std::string& out, double value)
+        {
+            char buffer[32];
+            std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr - buffer);
+        }
+
+        template <unsigned int Set = Metrics::All>
+        static void append_header(std::string& out)
+        {
+            append_padded(out, "Symbol", symbol_width);
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+            {
+                append_padded(out, "Mean Trade Time", value_width);
+                append_padded(out, "Median Trade Time", value_width);
+                append_padded(out, "Longest Trade Time", value_width);
+            }
+            if constexpr (Metrics::has(Set, Metrics::TickGaps))
+            {
+                append_padded(out, "Mean Tick Time", value_width);
+                append_padded(out, "Median Tick Time", value_width);
+                append_padded(out, "Longest Tick Time", value_width);
+            }
+            if constexpr (Metrics::has(Set, Metrics::Spreads))
+            {
+                append_padded(out, "Mean Spread", value_width);
+                append_padded(out, "Median Spread", value_width);
+            }
+            out.push_back('\n');
+        }
+
+        template <unsigned int Set = Metrics::All>
+        static void append_row(std::string& out, std::string_view symbol, const BookSummary& summary)
+        {
+            /* The trade times have 6 decimals, the rest 4 */
+            append_padded(out, symbol, symbol_width);
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+            {
+                append_fixed(out, summary.mean_time_trades, 6, value_width);
+                append_fixed(out, summary.median_time_trades, 6, value_width);
+                append_fixed(out, summary.longest_time_trades, 6, value_width);
+            }
+            if constexpr (Metrics::has(Set, Metrics::TickGaps))
+            {
+                append_fixed(out, summary.mean_time_tick, 4, value_width);
+                append_fixed(out, summary.median_time_tick, 4, value_width);
+                append_fixed(out, summary.longest_time_tick, 4, value_width);
+            }
+            if constexpr (Metrics::has(Set, Metrics::Spreads))
+            {
+                append_fixed(out, summary.mean_spread, 4, value_width);
+                append_fixed(out, summary.median_spread, 4, value_width);
+            }
+            out.push_back('\n');
+        }
+
+        template <unsigned int Set = Metrics::All>
+        static void append_csv_header(std::string& out)
+        {
+            out.append("symbol");
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+            {
+                out.append(",mean_trade_time,median_trade_time,longest_trade_time");
+            }
+            if constexpr (Metrics::has(Set, Metrics::TickGaps))
+            {
+                out.append(",mean_tick_time,median_tick_time,longest_tick_time");
+            }
+            if constexpr (Metrics::has(Set, Metrics::Spreads))
+            {
+                out.append(",mean_spread,median_spread");
+            }
+            out.push_back('\n');
+        }
+
+        template <unsigned int Set = Metrics::All>
+        static void append_csv_row(std::string& out, std::string_view symbol, const BookSummary& summary)
+        {
+            if (symbol.find_first_of(",\"\n") == std::string_view::npos)
+            {
+                out.append(symbol);
+            }
+            else
+            {
+                out.push_back('"');
+                for (char c : symbol)
+                {
+                    out.append(c == '"' ? 2 : 1, c);
+                }
+                out.push_back('"');
+            }
+            auto append_value = [&out](double value)
+            {
+                out.push_back(',');
+                append_shortest(out, value);
+            };
+            if constexpr (Metrics::has(Set, Metrics::TradeGaps))
+            {
+                append_value(summary.mean_time_trades);
+                append_value(summary.median_time_trades);
+                append_value(summary.longest_time_trades);
+            }
+            if constexpr (Metrics::has(Set, Metrics::TickGaps))
+            {
+                append_value(summary.mean_time_tick);
+                append_value(summary.median_time_tick);
+                append_value(summary.longest_time_tick);
+            }
+            if constexpr (Metrics::has(Set, Metrics::Spreads))
+            {
+                append_value(summary.mean_spread);
+                append_value(summary.median_spread);
+            }
+            out.push_back('\n');
+        }
+
+        template <typename Render>
+        static void render(std::string& out, std::size_t count, std::size_t item_size, Render render_item,
+                           unsigned int threads_num = std::thread::hardware_concurrency())
+        {
+            /* Append render_item(part, i) for i in [0, count) to out, in order.
+            :param item_size is the expected length of an item, the buffers are reserved for it
+            */
+            std::size_t threads = std::min<std::size_t>(std::max(1u, threads_num), count / rows_per_thread);
+            if (threads <= 1)
+            {
+                out.reserve(out.size() + count * item_size);
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    render_item(out, i);
+                }
+                return;
+            }
+            std::vector<std::string> parts(threads);
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; t++)
+            {
+                workers.emplace_back([&, t]()
+                {
+                    std::size_t begin = count * t / threads;
+                    std::size_t end = count * (t + 1) / threads;
+                    parts[t].reserve((end - begin) * item_size);
+                    for (std::size_t i = begin; i < end; i++)
+                    {
+                        render_item(parts[t], i);
+                    }
+                });
+            }
+            for (std::thread& worker : workers)
+            {
+                worker.join();
+            }
+            std::size_t total = out.size();
+            for (const std::string& part : parts)
+            {
+                total += part.size();
+            }
+            out.reserve(total);
+            for (const std::string& part : parts)
+            {
+                out.append(part);
+            }
+        }
+
+        template <unsigned int Set = Metrics::All>
+        static std::string format(const std::vector<BookSummary>& summaries, SummaryFormat format = SummaryFormat::Text)
+        {
+            /* The whole table with its header, in the order of the summaries */
+            std::vector<std::string_view> names = symbol_names(summaries);
+            std::string out;
+            if (format == SummaryFormat::Csv)
+            {
+                append_csv_header<Set>(out);
+                render(out, summaries.size(), row_width, [&](std::string& part, std::size_t i)
+                {
+                    append_csv_row<Set>(part, names[i], summaries[i]);
+                });
+                return out;
+            }
+            append_header<Set>(out);
+            render(out, summaries.size(), row_width, [&](std::string& part, std::size_t i)
+            {
+                append_row<Set>(part, names[i], summaries[i]);
+            });
+            return out;
+        }
+
+        static std::vector<std::string_view> symbol_names(const std::vector<BookSummary>& summaries)
+        {
+            /* The names are resolved up front, so the rendering threads do not take the lock of the dictionary */
+            const SymbolDictionary& dictionary = SymbolDictionary::global();
+            std::vector<std::string_view> names;
+            names.reserve(summaries.size());
+            for (const BookSummary& summary : summaries)
+            {
+                names.push_back(dictionary.name(summary.symbol));
+            }
+            return names;
+        }
+
+        static void write(const std::string& destination_file, const std::string& content)
+        {
+            std::ofstream file(destination_file);
+            if (!file)
+            {
+                std::cerr << "Failed to open file for writing: " << destination_file << std::endl;
+                return;
+            }
+            file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        }
+};
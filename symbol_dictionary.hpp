@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "arena.hpp"
+
+typedef std::uint32_t SymbolId;
+typedef std::uint16_t ConditionId;
+
+class SymbolDictionary
+{
+    /* Interns every ticker once and assigns it a dense integer id (0, 1, 2, ...).
+    The ids are passed through the hot path instead of the strings, the names are resolved only for the output.
+    The characters of the names are stored in a MonotonicArena which lives as long as the dictionary,
+    so interning a new name costs no allocation of its own and the views returned by name() never dangle.
+    The dictionary is shared by all threads, interning takes a lock (see SymbolCache for the lock-free fast path).
+    */
+    private:
+        mutable std::mutex mutex;
+        MonotonicArena characters{1 << 12};
+        std::vector<std::string_view> names; // views into "characters"
+        std::unordered_map<std::string_view, SymbolId> ids;
+
+    public:
+        SymbolDictionary() = default;
+        SymbolDictionary(const SymbolDictionary&) = delete;
+        SymbolDictionary& operator=(const SymbolDictionary&) = delete;
+
+        static SymbolDictionary& global()
+        {
+            static SymbolDictionary dictionary;
+            return dictionary;
+        }
+
+        static SymbolDictionary& conditions()
+        {
+            /* Dictionary of the condition codes (e.g. "XT|O"), the empty code has the id 0 */
+            static SymbolDictionary dictionary;
+            static bool initialized = (dictionary.intern(std::string_view()), true);
+            (void)initialized;
+            return dictionary;
+        }
+
+        SymbolId intern(std::string_view name)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = ids.find(name);
+            if (it != ids.end())
+            {
+                return it->second;
+            }
+            SymbolId id = static_cast<SymbolId>(names.size());
+            names.push_back(characters.copy(name));
+            ids.emplace(names.back(), id);
+            return id;
+        }
+
+        bool find(std::string_view name, SymbolId& id) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = ids.find(name);
+            if (it == ids.end())
+            {
+                return false;
+            }
+            id = it->second;
+            return true;
+        }
+
+        std::string_view name(SymbolId id) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return names[id];
+        }
+
+        std::size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return names.size();
+        }
+};
+
+class SymbolCache
+{
+    /* Per-thread front of the SymbolDictionary: the symbols seen by the thread are looked up without a lock,
+    only the first occurrence of a symbol goes to the shared dictionary
+    */
+    private:
+        SymbolDictionary* dictionary;
+        std::unordered_map<std::string_view, SymbolId> ids; // keys are views of the strings in the dictionary
+
+    public:
+        SymbolCache(SymbolDictionary& dictionary = SymbolDictionary::global()): dictionary{&dictionary} {}
+
+        SymbolId intern(std::string_view name)
+        {
+            auto it = ids.find(name);
+            if (it != ids.end())
+            {
+                return it->second;
+            }
+            SymbolId id = dictionary->intern(name);
+            ids.emplace(dictionary->name(id), id);
+            return id;
+        }
+};
@@ -0,0 +1,6 @@
+#include "tests.hpp"
+
+int main()
+{
+    return run_tests() == 0 ? 0 : 1;
+}
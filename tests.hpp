@@ -1,8 +1,1143 @@
+#pragma once
+
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+#include "data_extractor.hpp"
+#include "correlation.hpp"
+#include "bench/market_data_generator.hpp"
 
 // make tests for all static functions
+// Every test function checks one component, a failed check is reported with its line and counted
+
+static int failed_checks = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+static void check(bool condition, const char* text, const char* file, int line)
+{
+    if (!condition)
+    {
+        std::cerr<<file<<":"<<line<<": check failed: "<<text<<std::endl;
+        failed_checks++;
+    }
+}
+
+static std::string temporary_path(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / ("orderbook_tests_" + name)).string();
+}
+
+static void write_text(const std::string& path, const std::string& text)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+static std::string read_text(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+static bool same_summary(const BookSummary& a, const BookSummary& b)
+{
+    return a.symbol == b.symbol && a.mean_time_trades == b.mean_time_trades && a.median_time_trades == b.median_time_trades
+        && a.longest_time_trades == b.longest_time_trades && a.mean_time_tick == b.mean_time_tick
+        && a.median_time_tick == b.median_time_tick && a.longest_time_tick == b.longest_time_tick
+        && a.mean_spread == b.mean_spread && a.median_spread == b.median_spread;
+}
+
+static bool same_summaries(const std::vector<BookSummary>& a, const std::vector<BookSummary>& b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        if (!same_summary(a[i], b[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string input_line(const std::string& symbol, double bid, double ask, double trade, int type,
+                              std::uint32_t date, double seconds, const std::string& condition = "XT")
+{
+    /* A line in the column layout of Sample_data.txt */
+    std::ostringstream line;
+    line<<symbol<<",1,"<<bid<<","<<ask<<","<<trade<<",100,200,50,"<<type<<",0,"<<date<<","<<seconds
+        <<","<<trade<<",1,"<<condition<<",@1\n";
+    return line.str();
+}
+
+static std::vector<Order> generated_orders(const std::vector<SymbolId>& symbols, std::size_t count, std::uint64_t seed)
+{
+    /* Deterministic orders of the symbols with increasing times, all update types and repeated prices */
+    std::vector<Order> orders;
+    std::uint64_t state = seed;
+    std::int64_t time = Timestamp::midnight(20150420) + 8 * 3600 * Timestamp::nanoseconds_per_second;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::uint64_t random = state >> 33;
+        time += static_cast<std::int64_t>(random % 3) * 250000000; // equal times happen as well
+        std::int64_t bid = 1000000 + static_cast<std::int64_t>(random % 7) * 100;
+        std::int64_t ask = bid + 100 + static_cast<std::int64_t>(random % 3) * 100;
+        UpdateType type = static_cast<UpdateType>(random / 7 % 3);
+        orders.push_back(Order(symbols[random / 21 % symbols.size()], bid, ask, bid + 50, 100, 200,
+                               static_cast<std::uint32_t>(random % 1000), 0, type, 20150420, time));
+    }
+    return orders;
+}
+
+static std::vector<SymbolId> test_symbols(std::size_t count)
+{
+    std::vector<SymbolId> symbols;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        symbols.push_back(SymbolDictionary::global().intern("TEST" + std::to_string(i) + " NO Equity"));
+    }
+    return symbols;
+}
+
+struct SortedReference
+{
+    /* The statistics as the original OrderBook computed them: from a sorted copy of all the values */
+    double mean = 0.0;
+    double median = 0.0;
+    double max = 0.0;
+
+    explicit SortedReference(std::vector<long long> values)
+    {
+        if (values.empty())
+        {
+            return;
+        }
+        std::sort(values.begin(), values.end());
+        long long sum = 0;
+        for (long long value : values)
+        {
+            sum += value;
+        }
+        std::size_t middle = values.size() / 2;
+        mean = static_cast<double>(sum) / values.size();
+        median = values.size() % 2 == 0 ? static_cast<double>(values[middle - 1] + values[middle]) / 2
+                                        : static_cast<double>(values[middle]);
+        max = static_cast<double>(values.back());
+    }
+};
+
+static void test_running_statistics()
+{
+    /* The incremental accumulators give the statistics of the sorted values after every insertion:
+    random values with many duplicates, odd and even counts
+    */
+    RunningStats<long long> stats;
+    RunningMedian<long long> median;
+    std::vector<long long> values;
+    std::uint64_t state = 1;
+    bool all_equal = true;
+    for (std::size_t i = 0; i < 1000; i++)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        long long value = static_cast<long long>((state >> 33) % 50) - 10; // duplicates and negative values
+        values.push_back(value);
+        stats.add(value);
+        median.add(value);
+        SortedReference reference(values);
+        all_equal = all_equal && stats.mean() == reference.mean && stats.median() == reference.median
+                 && stats.max() == reference.max && median.median() == reference.median && stats.size() == values.size();
+    }
+    CHECK(all_equal);
+
+    RunningStats<long long> even;
+    for (long long value : {4, 1, 3, 2})
+    {
+        even.add(value);
+    }
+    CHECK(even.median() == 2.5 && even.mean() == 2.5 && even.max() == 4.0);
+    RunningStats<long long> repeated;
+    for (long long value : {5, 5, 1, 5})
+    {
+        repeated.add(value);
+    }
+    CHECK(repeated.median() == 5.0 && repeated.mean() == 4.0 && repeated.max() == 5.0);
+    CHECK(RunningStats<long long>().median() == 0.0 && RunningStats<long long>().mean() == 0.0);
+
+    // the trade gaps of a book: random gaps including equal times, after every trade
+    SymbolId symbol = SymbolDictionary::global().intern("RUNNING NO Equity");
+    OrderBook book(symbol);
+    std::vector<long long> gaps;
+    std::int64_t time = Timestamp::midnight(20150420);
+    all_equal = true;
+    for (std::size_t i = 0; i < 501; i++)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::int64_t gap = static_cast<std::int64_t>((state >> 33) % 8) * 250000000; // 0 to 1.75 seconds
+        time += gap;
+        if (i > 0)
+        {
+            gaps.push_back(gap);
+        }
+        book.addOrder(Order(symbol, 10000, 10100, 10050, 1, 1, 1, 0, UpdateType::Trade, 20150420, time));
+        SortedReference reference(gaps);
+        all_equal = all_equal && book.get_mean_time_trades() == reference.mean / 1e9
+                 && book.get_median_time_trades() == reference.median / 1e9
+                 && book.get_longest_time_trades() == reference.max / 1e9;
+    }
+    CHECK(all_equal);
+}
+
+static void test_quantile_sketch()
+{
+    /* The quantiles of the sketch are within the relative error of the exact ones, also after merging */
+    const double error = 0.01;
+    QuantileSketch sketch(error);
+    QuantileSketch first(error);
+    QuantileSketch second(error);
+    std::vector<double> values;
+    std::uint64_t state = 11;
+    for (std::size_t i = 0; i < 100000; i++)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        double value = std::exp(static_cast<double>(state >> 40) / (1 << 24) * 20.0 - 5.0); // 7 orders of magnitude
+        values.push_back(value);
+        sketch.add(value);
+        (i % 2 == 0 ? first : second).add(value);
+    }
+    first.merge(second);
+    std::sort(values.begin(), values.end());
+    for (double q : {0.0, 0.01, 0.25, 0.5, 0.9, 0.99, 1.0})
+    {
+        double exact = values[static_cast<std::size_t>(std::floor(q * (values.size() - 1)))];
+        CHECK(std::fabs(sketch.quantile(q) - exact) <= error * exact);
+        CHECK(first.quantile(q) == sketch.quantile(q));
+    }
+    CHECK(sketch.get_count() == values.size());
+    CHECK(sketch.get_bins_num() <= 2 * 2048);
+
+    QuantileSketch signs(error);
+    for (int value : {-1000, -10, 0, 10, 1000})
+    {
+        signs.add(value);
+    }
+    CHECK(std::fabs(signs.quantile(0.0) + 1000) <= error * 1000);
+    CHECK(signs.quantile(0.5) == 0.0);
+    CHECK(std::fabs(signs.quantile(1.0) - 1000) <= error * 1000);
+    CHECK(QuantileSketch(error).quantile(0.5) == 0.0);
+
+    // the approximate statistics of a book follow the sketch, the medians are read on request
+    RunningStats<long long> stats(StatisticsMode::Approximate, error);
+    for (long long value = 1; value <= 1001; value++)
+    {
+        stats.add(value);
+    }
+    CHECK(std::fabs(stats.median() - 501) <= error * 501);
+    CHECK(stats.mean() == 501.0 && stats.max() == 1001.0);
+}
+
+static void test_delimiter_scanner()
+{
+    /* Every vector kernel of this CPU finds the same positions as the scalar one, for all lengths and alignments */
+    std::string data;
+    std::uint64_t state = 7;
+    for (std::size_t i = 0; i < 1000; i++)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        static const char alphabet[] = "abc,\r\n0123456789.,,\n";
+        data.push_back(alphabet[(state >> 33) % (sizeof(alphabet) - 1)]);
+    }
+    std::vector<std::uint32_t> expected(data.size());
+    std::vector<std::uint32_t> actual(data.size());
+    for (ScannerKind kind : {ScannerKind::SSE2, ScannerKind::AVX2})
+    {
+        if (!DelimiterScanner::supports(kind))
+        {
+            continue;
+        }
+        DelimiterScanner::Kernel kernel = DelimiterScanner::kernel(kind);
+        bool all_equal = true;
+        for (std::size_t begin = 0; begin < 70; begin++)
+        {
+            for (std::size_t length = 0; begin + length <= data.size(); length += 1 + length / 8)
+            {
+                std::size_t count = DelimiterScanner::scan_scalar(data.data() + begin, length, expected.data());
+                all_equal = all_equal && kernel(data.data() + begin, length, actual.data()) == count
+                         && std::equal(expected.begin(), expected.begin() + count, actual.begin());
+            }
+        }
+        CHECK(all_equal);
+    }
+    std::uint32_t positions[8];
+    CHECK(DelimiterScanner::scan("a,b\r\n", 5, positions) == 3 && positions[0] == 1 && positions[1] == 3 && positions[2] == 4);
+}
+
+static void test_parallel_ingest()
+{
+    /* ReaderMode::Parallel gives the books of the serial stream for any chunk size and number of threads,
+    also with chunks smaller than a line, rejected rows and a file which does not end with a newline
+    */
+    GeneratorOptions generator;
+    generator.rows = 20000;
+    generator.symbols = 40;
+    generator.invalid_ratio = 0.05;
+    generator.seed = 5;
+    std::string path = temporary_path("parallel.csv");
+    CHECK(MarketDataGenerator(generator).write(path));
+    const std::string text = read_text(path);
+
+    for (std::size_t size : {1, 100, 4096})
+    {
+        std::vector<std::string_view> chunks = DataParser::split_chunks(text, size);
+        std::string joined;
+        bool aligned = true;
+        for (std::size_t i = 0; i < chunks.size(); i++)
+        {
+            joined += chunks[i];
+            aligned = aligned && (i + 1 == chunks.size() || chunks[i].back() == '\n');
+        }
+        CHECK(joined == text && aligned);
+    }
+
+    for (const std::string& content : {text, text.substr(0, text.size() - 1)})
+    {
+        write_text(path, content);
+        DataParser serial(path, 0);
+        serial.start(ReaderMode::Stream);
+        CHECK(serial.get_orders_table().getTotalOrders() > 0);
+        for (std::size_t chunk_size : {1, 97, 4096, 1 << 16})
+        {
+            for (unsigned int threads : {1u, 3u, 8u})
+            {
+                DataParser parallel(path, 0);
+                parallel.set_chunk_size(chunk_size);
+                parallel.set_threads_num(threads);
+                parallel.start(ReaderMode::Parallel);
+                CHECK(same_summaries(serial.get_orders_table().get_summaries(), parallel.get_orders_table().get_summaries()));
+                CHECK(serial.get_orders_table().getTotalOrders() == parallel.get_orders_table().getTotalOrders());
+            }
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+static void test_sharded_table()
+{
+    /* The sharded table gives the statistics of the serial one, orders after finish() are rejected */
+    std::vector<SymbolId> symbols = test_symbols(37);
+    std::vector<Order> orders = generated_orders(symbols, 20000, 9);
+    OrderTable serial;
+    ShardedOrderTable sharded(4, BookOptions(), 64); // a small queue, so the producer waits for the workers
+    for (const Order& order : orders)
+    {
+        serial.processOrder(order);
+        sharded.processOrder(order);
+    }
+    sharded.finish();
+    CHECK(same_summaries(serial.get_summaries(), sharded.get_summaries()));
+    CHECK(serial.getTotalOrders() == sharded.getTotalOrders());
+    CHECK(serial.getSymbolsNum() == sharded.getSymbolsNum());
+    CHECK(serial.getLongestTimeTrades() == sharded.getLongestTimeTrades());
+    for (std::size_t i = 0; i < sharded.getShardsNum(); i++)
+    {
+        for (SymbolId id : sharded.get_shard(i).get_symbol_ids())
+        {
+            CHECK(sharded.shard_of(id) == i && sharded.get_shard(i).get_book(id).getSymbolId() == id);
+        }
+    }
+    CHECK(!sharded.processOrder(orders.front()));
+    CHECK(serial.getTotalOrders() == sharded.getTotalOrders());
+}
+
+static void test_parser()
+{
+    /* Rows with an update type other than 1-3 are rejected, e.g. type 8 of Sample_data.txt */
+    InternCache cache;
+    std::array<std::string_view, 16> fields;
+    std::string trade = input_line("PARSER A", 158.1, 155.0, 156.0, 1, 20150420, 28800.5);
+    std::string unknown = input_line("PARSER A", 0.0, 0.0, 43.0, 8, 20150422, 28800.0, "");
+    std::size_t count = DataParser::split_line(trade, fields);
+    std::optional<Order> order = DataParser::parse_order(fields, count, cache);
+    CHECK(order && order->getType() == UpdateType::Trade && order->getTradeTicks() == 1560000
+          && order->getTime() == Timestamp::midnight(20150420) + 28800500000000LL);
+    count = DataParser::split_line(unknown, fields);
+    CHECK(!DataParser::parse_order(fields, count, cache));
+    CHECK(!DataParser::process_type(8) && DataParser::process_type(3) == UpdateType::ChangeToAsk);
+}
+
+static void test_order_cache()
+{
+    /* The orders loaded from the cache are those written, a truncated or corrupt cache is rejected */
+    std::vector<SymbolId> symbols = test_symbols(3);
+    ConditionId condition = static_cast<ConditionId>(SymbolDictionary::conditions().intern("XT|O"));
+    std::vector<Order> orders = generated_orders(symbols, 500, 3);
+    std::vector<OrderColumns> books;
+    for (Order& order : orders)
+    {
+        order = Order(order.getSymbolId(), order.getBidTicks(), order.getAskTicks(), order.getTradeTicks(),
+                      order.getBidVolume(), order.getAskVolume(), order.getTradeVolume(), condition,
+                      order.getType(), order.getDate(), order.getTime());
+        if (books.size() <= order.getSymbolId())
+        {
+            books.resize(order.getSymbolId() + 1);
+        }
+        books[order.getSymbolId()].push_back(order);
+    }
+    std::string path = temporary_path("cache");
+    CHECK(OrderCache::write(path, books, 1234, 5678));
+    {
+        OrderCacheReader reader(path);
+        CHECK(reader.matches(1234, 5678) && !reader.matches(1234, 5679));
+        CHECK(reader.getSymbolsNum() == symbols.size() && reader.getTotalOrders() == orders.size());
+        std::vector<Order> loaded;
+        reader.load([&loaded](const Order& order) { loaded.push_back(order); });
+        std::vector<Order> expected; // the cache is grouped by symbol, the orders of a symbol in the file order
+        for (SymbolId symbol : symbols)
+        {
+            for (const Order& order : orders)
+            {
+                if (order.getSymbolId() == symbol)
+                {
+                    expected.push_back(order);
+                }
+            }
+        }
+        bool all_equal = loaded.size() == expected.size();
+        for (std::size_t i = 0; all_equal && i < loaded.size(); i++)
+        {
+            all_equal = loaded[i].getSymbolId() == expected[i].getSymbolId() && loaded[i].getTime() == expected[i].getTime()
+                     && loaded[i].getBidTicks() == expected[i].getBidTicks() && loaded[i].getAskTicks() == expected[i].getAskTicks()
+                     && loaded[i].getTradeTicks() == expected[i].getTradeTicks()
+                     && loaded[i].getBidVolume() == expected[i].getBidVolume()
+                     && loaded[i].getAskVolume() == expected[i].getAskVolume()
+                     && loaded[i].getTradeVolume() == expected[i].getTradeVolume()
+                     && loaded[i].getType() == expected[i].getType() && loaded[i].getDate() == expected[i].getDate()
+                     && loaded[i].getConditionCode() == "XT|O";
+        }
+        CHECK(all_equal);
+    }
+
+    const std::string original = read_text(path);
+    auto corrupted = [&path, &original](std::size_t offset, const void* bytes, std::size_t size)
+    {
+        std::string text = original;
+        std::memcpy(&text[offset], bytes, size);
+        write_text(path, text);
+        return OrderCacheReader(path).is_valid();
+    };
+    CHECK(!corrupted(0, "XBCACHE", 8));
+    std::uint64_t huge = ~std::uint64_t(0) - 7; // wraps offset + block_size
+    std::size_t entry = sizeof(OrderCache::Header);
+    CHECK(!corrupted(entry + offsetof(OrderCache::Entry, rows), &huge, sizeof(huge)));
+    CHECK(!corrupted(entry + offsetof(OrderCache::Entry, offset), &huge, sizeof(huge)));
+    std::uint32_t far = 1u << 30;
+    std::size_t names = entry + symbols.size() * sizeof(OrderCache::Entry);
+    CHECK(!corrupted(entry + offsetof(OrderCache::Entry, name_offset), &far, sizeof(far)));
+    CHECK(!corrupted(names + offsetof(OrderCache::Name, offset), &far, sizeof(far)));
+    CHECK(!corrupted(names + offsetof(OrderCache::Name, length), &far, sizeof(far)));
+    CHECK(!corrupted(offsetof(OrderCache::Header, names_size), &huge, sizeof(huge)));
+    write_text(path, original.substr(0, original.size() - 8));
+    CHECK(!OrderCacheReader(path).is_valid());
+    write_text(path, original.substr(0, 20));
+    CHECK(!OrderCacheReader(path).is_valid());
+    write_text(path, original);
+    CHECK(OrderCacheReader(path).is_valid());
+    std::filesystem::remove(path);
+}
+
+static void test_follow()
+{
+    /* Lines appended to a followed file are processed as they arrive, a line written in two parts is joined,
+    the reading stops after the idle timeout and the final snapshot is the table at the end
+    */
+    std::string path = temporary_path("follow.csv");
+    std::string snapshot = temporary_path("follow_snapshot.txt");
+    std::string expected = temporary_path("follow_expected.txt");
+    std::string first = input_line("FOLLOW A", 10, 11, 10.5, 1, 20150420, 100);
+    std::string second = input_line("FOLLOW A", 10, 11, 10.25, 1, 20150420, 102.5);
+    std::string third = input_line("FOLLOW A", 10, 11, 10.75, 1, 20150420, 110);
+    write_text(path, "");
+    std::filesystem::remove(snapshot);
+
+    DataParser parser(path, 0);
+    FollowOptions options;
+    options.snapshot_file = snapshot;
+    options.snapshot_interval = std::chrono::milliseconds(60000); // only the final snapshot
+    options.poll_interval = std::chrono::milliseconds(5);
+    options.idle_timeout = std::chrono::milliseconds(300);
+    auto started = std::chrono::steady_clock::now();
+    std::thread follower([&parser, &options]() { parser.follow(options); });
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file << first << second.substr(0, second.size() / 2) << std::flush;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // the follower reaches the incomplete line
+        file << second.substr(second.size() / 2) << third << std::flush;
+    }
+    follower.join();
+    CHECK(std::chrono::steady_clock::now() - started >= options.idle_timeout);
+
+    const OrderTable& table = parser.get_orders_table();
+    SymbolId symbol = SymbolDictionary::global().intern("FOLLOW A");
+    CHECK(table.getTotalOrders() == 3);
+    CHECK(table.is_symbol_exists(symbol) && table.get_book(symbol).get_longest_time_trades() == 7.5);
+    parser.save_orders(expected);
+    CHECK(std::filesystem::exists(snapshot) && read_text(snapshot) == read_text(expected));
+    CHECK(!std::filesystem::exists(snapshot + ".tmp"));
+    std::filesystem::remove(path);
+    std::filesystem::remove(snapshot);
+    std::filesystem::remove(expected);
+}
+
+static void test_rolling_window()
+{
+    /* The window covers (now - duration, now], older events are evicted, the capacity evictions are counted */
+    RollingWindow<std::int64_t> window(10, 100);
+    window.add(0, 5);
+    window.add(5, 1);
+    window.add(9, 3);
+    CHECK(window.size() == 3 && window.mean() == 3.0 && window.median() == 3.0);
+    window.advance(10); // the event at 0 is exactly "duration" old
+    CHECK(window.size() == 2 && window.mean() == 2.0 && window.median() == 2.0);
+    window.add(15, 7); // evicts the event at 5
+    CHECK(window.size() == 2 && window.mean() == 5.0 && window.median() == 5.0);
+    window.advance(100);
+    CHECK(window.empty() && window.mean() == 0.0 && window.median() == 0.0);
+    CHECK(window.get_truncated() == 0);
+
+    RollingWindow<std::int64_t> bounded(1000, 4);
+    for (std::int64_t time = 0; time < 6; time++)
+    {
+        bounded.add(time, time);
+    }
+    CHECK(bounded.size() == 4 && bounded.get_truncated() == 2);
+    CHECK(bounded.mean() == 3.5 && bounded.median() == 3.5);
+
+    RingBuffer<int> ring(3);
+    for (int i = 0; i < 10; i++)
+    {
+        if (ring.full())
+        {
+            ring.pop_front();
+        }
+        ring.push_back(i);
+    }
+    CHECK(ring.size() == 3 && ring.front() == 7 && ring[2] == 9);
+}
+
+static void test_round_numbers()
+{
+    /* The chi-square statistic and its p-value against known values of the distribution with 9 degrees of freedom,
+    the SSE2 digit counting and the batch digit kernels against a plain loop
+    */
+    auto histogram_of = [](std::initializer_list<std::uint64_t> counts)
+    {
+        DigitHistogram histogram;
+        unsigned int digit = 0;
+        for (std::uint64_t count : counts)
+        {
+            histogram.add(digit++, count);
+        }
+        return histogram;
+    };
+    auto close = [](double value, double expected) { return std::fabs(value - expected) <= 1e-9 * expected; };
+    DigitHistogram uniform = histogram_of({10, 10, 10, 10, 10, 10, 10, 10, 10, 10});
+    CHECK(uniform.chi_square() == 0.0 && uniform.p_value() == 1.0);
+    DigitHistogram slight = histogram_of({20, 10, 10, 10, 10, 10, 10, 10, 10, 10}); // the series of Q(a, x)
+    CHECK(close(slight.chi_square(), 90.0 / 11) && close(slight.p_value(), 0.5159324048536891));
+    DigitHistogram strong = histogram_of({30, 10, 10, 10, 10, 10, 10, 10, 10, 10}); // the continued fraction
+    CHECK(close(strong.chi_square(), 30.0) && close(strong.p_value(), 0.00043872177097947963));
+    CHECK(close(strong.share(0), 0.25) && strong.total() == 120);
+    CHECK(DigitHistogram().chi_square() == 0.0 && DigitHistogram().p_value() == 1.0);
+
+    std::uint64_t state = 13;
+    auto random = [&state]()
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+    std::vector<std::uint8_t> digits(5000); // more than 255 vector steps, so the byte lanes are flushed
+    for (std::uint8_t& digit : digits)
+    {
+        digit = static_cast<std::uint8_t>(random() % 10);
+    }
+    bool all_equal = true;
+    for (std::size_t size : {0, 1, 15, 16, 17, 4080, 4081, 5000})
+    {
+        DigitHistogram counted;
+        DigitKernel::count_digits(digits.data(), size, counted);
+        for (unsigned int d = 0; d < 10; d++)
+        {
+            all_equal = all_equal && counted.get_count(d) == static_cast<std::uint64_t>(std::count(digits.begin(), digits.begin() + size, d));
+        }
+    }
+    CHECK(all_equal);
+
+    // whole batches of 32-bit magnitudes and batches with larger ones take different paths
+    std::vector<std::int64_t> ticks;
+    for (std::size_t i = 0; i < 3 * DigitKernel::batch_size + 7; i++)
+    {
+        std::int64_t value = static_cast<std::int64_t>(random());
+        if (i / DigitKernel::batch_size == 1 && i % 100 == 0)
+        {
+            value *= 1 << 20;
+        }
+        ticks.push_back(i % 3 == 0 ? -value : value);
+    }
+    for (std::int64_t divisor : {1, 10, 100, 1000, 10000})
+    {
+        DigitHistogram batched;
+        DigitKernel::price_digits(ticks.data(), ticks.size(), divisor, batched);
+        DigitHistogram scalar;
+        for (std::int64_t value : ticks)
+        {
+            scalar.add(static_cast<unsigned int>((value < 0 ? -value : value) / divisor % 10));
+        }
+        for (unsigned int d = 0; d < 10; d++)
+        {
+            all_equal = all_equal && batched.get_count(d) == scalar.get_count(d);
+        }
+    }
+    CHECK(all_equal);
+}
+
+static void test_civil_dates()
+{
+    /* Timestamp::days_from_civil against counting the days one by one from the epoch */
+    static const unsigned int month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    std::int64_t days = 0;
+    bool all_equal = true;
+    for (std::int64_t year = 1970; year < 2110; year++)
+    {
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        for (unsigned int month = 1; month <= 12; month++)
+        {
+            unsigned int length = month_days[month - 1] + (month == 2 && leap ? 1 : 0);
+            for (unsigned int day = 1; day <= length; day++)
+            {
+                all_equal = all_equal && Timestamp::days_from_civil(year, month, day) == days;
+                days++;
+            }
+        }
+    }
+    CHECK(all_equal);
+    CHECK(Timestamp::days_from_civil(1969, 12, 31) == -1);
+    CHECK(Timestamp::days_from_civil(1900, 3, 1) - Timestamp::days_from_civil(1900, 2, 28) == 1); // 1900 is not leap
+    CHECK(Timestamp::days_from_civil(2000, 3, 1) - Timestamp::days_from_civil(2000, 2, 28) == 2); // 2000 is leap
+    CHECK(Timestamp::midnight(20150420) == 16545 * Timestamp::nanoseconds_per_day);
+
+    DateCache dates;
+    CHECK(dates.timestamp(20150420, 5) == Timestamp::midnight(20150420) + 5);
+    CHECK(dates.timestamp(20150421, 0) == Timestamp::midnight(20150421));
+
+    auto point = DataParser::createTimePoint(2015, 4, 20, 28800.125);
+    std::int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(point.time_since_epoch()).count();
+    CHECK(nanoseconds == Timestamp::midnight(20150420) + 28800125000000LL);
+    std::array<int, 3> date = DataParser::parse_date("20150420");
+    CHECK(date[0] == 2015 && date[1] == 4 && date[2] == 20);
+}
+
+static void test_compressed_reader()
+{
+#ifdef ORDERBOOK_ZLIB
+    /* The inflated data is the original text, for concatenated members, zero padding and small buffers */
+    std::string text;
+    for (int i = 0; i < 20000; i++)
+    {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    auto compress = [](const std::string& path, const std::string& data)
+    {
+        gzFile file = gzopen(path.c_str(), "wb");
+        gzwrite(file, data.data(), static_cast<unsigned int>(data.size()));
+        gzclose(file);
+        return read_text(path);
+    };
+    auto inflate_all = [](const std::string& path, std::size_t buffer_size, bool& failed)
+    {
+        CompressedReader reader(path, buffer_size, 4);
+        std::string result;
+        while (const CompressedReader::Chunk* chunk = reader.next())
+        {
+            result.append(chunk->data, chunk->size);
+            reader.recycle();
+        }
+        failed = reader.failed();
+        return result;
+    };
+    std::string path = temporary_path("input.gz");
+    std::string member = compress(path, text);
+    CHECK(CompressedReader::detect(path) == Compression::Gzip);
+    bool failed = true;
+    CHECK(inflate_all(path, 1 << 16, failed) == text && !failed);
+    CHECK(inflate_all(path, 7, failed) == text && !failed);
+
+    write_text(path, member + compress(path, "last\n"));
+    CHECK(inflate_all(path, 1 << 12, failed) == text + "last\n" && !failed);
+
+    write_text(path, member + std::string(1 << 19, '\0')); // the padding spans several reads of the input
+    CHECK(inflate_all(path, 1 << 12, failed) == text && !failed);
+
+    write_text(path, member.substr(0, member.size() / 2));
+    std::cerr<<"(an error about a truncated file is expected)"<<std::endl;
+    inflate_all(path, 1 << 12, failed);
+    CHECK(failed);
+
+    write_text(path, member + "garbage");
+    inflate_all(path, 1 << 12, failed);
+    CHECK(failed);
+    std::filesystem::remove(path);
+#endif
+}
+
+static std::string iostream_summary(const std::vector<BookSummary>& summaries)
+{
+    /* The table as OrderTable::save wrote it with the stream manipulators before SummaryFormatter */
+    std::ostringstream file;
+    file << std::left << std::setw(35) << "Symbol"
+        << std::setw(20) << "Mean Trade Time"
+        << std::setw(20) << "Median Trade Time"
+        << std::setw(20) << "Longest Trade Time"
+        << std::setw(20) << "Mean Tick Time"
+        << std::setw(20) << "Median Tick Time"
+        << std::setw(20) << "Longest Tick Time"
+        << std::setw(20) << "Mean Spread"
+        << std::setw(20) << "Median Spread"
+        << std::endl;
+    for (const BookSummary& summary : summaries)
+    {
+        file << std::left << std::setw(35) << SymbolDictionary::global().name(summary.symbol)
+            << std::setw(20) << std::fixed << std::setprecision(6) << summary.mean_time_trades
+            << std::setw(20) << summary.median_time_trades
+            << std::setw(20) << summary.longest_time_trades
+            << std::setw(20) << std::fixed << std::setprecision(4) << summary.mean_time_tick
+            << std::setw(20) << summary.median_time_tick
+            << std::setw(20) << summary.longest_time_tick
+            << std::setw(20) << summary.mean_spread
+            << std::setw(20) << summary.median_spread
+            << std::endl;
+    }
+    return file.str();
+}
+
+static void test_summary_formatter()
+{
+    /* The text table is byte for byte the output of the stream manipulators, on one thread and on several,
+    the csv values read back to the same doubles
+    */
+    std::vector<double> values = {0.0, 0.5, 1.0 / 3, 2.0 / 3, 0.1234565, 0.00005, 0.000049999, 123456.789012,
+                                  -0.25, 1e15 + 0.5, 12345678901234567.0, 1e25, 5e-324};
+    std::vector<BookSummary> summaries;
+    for (std::size_t i = 0; i < 10000; i++) // more rows than SummaryFormatter::rows_per_thread
+    {
+        std::string name = i == 0 ? "A SYMBOL NAME LONGER THAN THE WIDTH OF ITS COLUMN" : "FORMAT " + std::to_string(i);
+        SymbolId symbol = SymbolDictionary::global().intern(name);
+        auto value = [&values, i](std::size_t column) { return values[(i * 7 + column * 3) % values.size()] * (1 + i % 5); };
+        summaries.push_back(BookSummary{symbol, value(0), value(1), value(2), value(3), value(4), value(5), value(6), value(7)});
+    }
+    std::vector<BookSummary> few(summaries.begin(), summaries.begin() + 50);
+    CHECK(SummaryFormatter::format(few) == iostream_summary(few));
+    CHECK(SummaryFormatter::format(summaries) == iostream_summary(summaries));
+    std::ostringstream snapshot;
+    OrderTable::save_summaries(snapshot, few);
+    CHECK(snapshot.str() == iostream_summary(few));
+
+    // the csv format has no stream predecessor: the fields are the names and the values read back exactly
+    std::istringstream csv(SummaryFormatter::format(few, SummaryFormat::Csv));
+    std::string line;
+    std::getline(csv, line);
+    CHECK(line == "symbol,mean_trade_time,median_trade_time,longest_trade_time,mean_tick_time,median_tick_time,"
+                  "longest_tick_time,mean_spread,median_spread");
+    bool all_equal = true;
+    for (const BookSummary& summary : few)
+    {
+        std::getline(csv, line);
+        std::istringstream fields(line);
+        std::string name;
+        std::getline(fields, name, ',');
+        all_equal = all_equal && name == SymbolDictionary::global().name(summary.symbol);
+        for (double expected : {summary.mean_time_trades, summary.median_time_trades, summary.longest_time_trades,
+                                summary.mean_time_tick, summary.median_time_tick, summary.longest_time_tick,
+                                summary.mean_spread, summary.median_spread})
+        {
+            std::string field;
+            std::getline(fields, field, ',');
+            std::istringstream number(field);
+            double value = 0.0;
+            number >> value;
+            all_equal = all_equal && !number.fail() && number.eof() && value == expected;
+        }
+    }
+    CHECK(all_equal && !std::getline(csv, line));
+}
+
+static void test_time_index()
+{
+    /* As-of quotes and inclusive trade ranges against a linear scan, including the edges and equal times */
+    SymbolId symbol = SymbolDictionary::global().intern("TIME INDEX NO Equity");
+    OrderTable table;
+    std::vector<Order> orders;
+    for (std::int64_t i = 0; i < 300; i++)
+    {
+        std::int64_t time = 1000 + (i / 2) * 10; // pairs of equal times, more than one block of SortedTimes
+        UpdateType type = i % 3 == 0 ? UpdateType::Trade : UpdateType::ChangeToBid;
+        orders.push_back(Order(symbol, 10000 + i, 20000 + i, 15000 + i, 1, 2, 3, 0, type, 20150420, time));
+        table.processOrder(orders.back());
+    }
+    TimeIndex index = TimeIndex::build(table);
+    QuoteSnapshot quote;
+    CHECK(!index.quote_at(symbol, 999, quote));
+    CHECK(index.quote_at(symbol, 1000, quote) && quote.bid_price == 10001); // the last of the equal times
+    CHECK(index.quote_at(symbol, 1005, quote) && quote.time == 1000);
+    CHECK(index.quote_at(symbol, 1 << 30, quote) && quote.bid_price == 10299);
+    CHECK(!index.quote_at(symbol + 1000, 1000, quote));
+
+    bool all_equal = true;
+    for (std::int64_t time = 990; time < 2520; time += 3)
+    {
+        const Order* latest = nullptr;
+        for (const Order& order : orders)
+        {
+            if (order.getTime() <= time)
+            {
+                latest = &order;
+            }
+        }
+        bool found = index.quote_at(symbol, time, quote);
+        all_equal = all_equal && found == (latest != nullptr) && (!found || quote.bid_price == latest->getBidTicks());
+    }
+    CHECK(all_equal);
+
+    auto count_trades = [&orders](std::int64_t begin, std::int64_t end)
+    {
+        std::size_t count = 0;
+        for (const Order& order : orders)
+        {
+            count += order.getType() == UpdateType::Trade && order.getTime() >= begin && order.getTime() <= end;
+        }
+        return count;
+    };
+    TradeRange range = index.trades_between(symbol, 1000, 1030);
+    CHECK(range.size == count_trades(1000, 1030) && range.times[0] == 1000 && range.times[range.size - 1] == 1030);
+    CHECK(index.trades_between(symbol, 1031, 1039).empty()); // no order within the interval
+    CHECK(index.trades_between(symbol, 1030, 1000).empty());  // begin after end
+    CHECK(index.trades_between(symbol, 0, 999).empty());
+    CHECK(index.trades_between(symbol, 0, 1 << 30).size == count_trades(0, 1 << 30));
+    all_equal = true;
+    for (std::int64_t begin = 990; begin < 2520; begin += 37)
+    {
+        all_equal = all_equal && index.trades_between(symbol, begin, begin + 200).size == count_trades(begin, begin + 200);
+    }
+    CHECK(all_equal);
+}
+
+static void test_correlation()
+{
+    /* Known correlations of mid prices quoted at uneven times, the as-of alignment with the grid,
+    the tiled product against the naive one and the rejection of a grid above max_grid_values
+    */
+    const std::int64_t second = Timestamp::nanoseconds_per_second;
+    const std::int64_t start = Timestamp::midnight(20150420);
+    const std::int64_t steps = 16; // a multiple of 4, so the return patterns below have zero mean
+    static const int up_down[4] = {1, 1, -1, -1};
+    static const int alternating[4] = {1, -1, 1, -1};
+    std::vector<SymbolId> symbols;
+    for (const char* name : {"CORR A", "CORR B", "CORR C", "CORR D", "CORR FLAT"})
+    {
+        symbols.push_back(SymbolDictionary::global().intern(name));
+    }
+    OrderTable table;
+    auto quote = [&table](SymbolId symbol, std::int64_t time, std::int64_t mid)
+    {
+        table.processOrder(Order(symbol, mid - 100, mid + 100, 0, 1, 1, 0, 0, UpdateType::ChangeToBid, 20150420, time));
+    };
+    // mid prices as powers of two, so every log return is exactly +-log(2):
+    // B = 3 A (correlation 1), C = 4 / A (-1), D alternates and is orthogonal to A (0), FLAT never moves (NaN)
+    std::int64_t a = 0; // exponent of A
+    std::int64_t d = 0;
+    std::uint64_t state = 17;
+    for (std::int64_t k = 0; k <= steps; k++)
+    {
+        if (k > 0)
+        {
+            a += up_down[(k - 1) % 4];
+            d += alternating[(k - 1) % 4];
+        }
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::int64_t jitter = static_cast<std::int64_t>((state >> 33) % (second / 2)); // C within half a step before the grid time
+        std::int64_t time = start + k * second;
+        quote(symbols[0], time, 1000 << a);
+        quote(symbols[1], k == 0 ? time : time - second / 2, 3000 << a);
+        quote(symbols[2], k == 0 ? time : time - jitter, 1000 << (2 - a));
+        if (k > 0)
+        {
+            quote(symbols[2], time - jitter / 2, 1000 << (2 - a)); // a repeated quote does not change the mid
+        }
+        quote(symbols[3], k == 0 ? time : time - second / 3, 1000 << d);
+        quote(symbols[4], k == 0 ? time : time - second / 4, 5000);
+    }
+    TimeIndex index = TimeIndex::build(table);
+    TimeGrid grid = CorrelationEngine::common_grid(index, symbols, second);
+    CHECK(grid.start == start && grid.step == second && grid.points == static_cast<std::size_t>(steps) + 1);
+    std::vector<double> mids(grid.points);
+    index.get_symbol(symbols[2])->sample_mids(grid.start, grid.step, grid.points, mids.data());
+    a = 0;
+    bool aligned = true;
+    for (std::int64_t k = 0; k <= steps; k++)
+    {
+        a += k > 0 ? up_down[(k - 1) % 4] : 0;
+        aligned = aligned && mids[k] == static_cast<double>(1000 << (2 - a));
+    }
+    CHECK(aligned);
+    index.get_symbol(symbols[0])->sample_mids(start - second, second, 2, mids.data());
+    CHECK(std::isnan(mids[0]) && mids[1] == 1000.0); // nothing is known before the first quote
+
+    CorrelationMatrix matrix = CorrelationEngine::correlate(index, symbols, second, 3);
+    auto close = [](double value, double expected) { return std::fabs(value - expected) <= 1e-12; };
+    CHECK(matrix.size() == symbols.size() && close(matrix.at(0, 0), 1.0));
+    CHECK(close(matrix.at(0, 1), 1.0) && close(matrix.at(1, 0), 1.0));
+    CHECK(close(matrix.at(0, 2), -1.0) && close(matrix.at(1, 2), -1.0));
+    CHECK(close(matrix.at(0, 3), 0.0) && close(matrix.at(2, 3), 0.0));
+    CHECK(std::isnan(matrix.at(0, 4)) && std::isnan(matrix.at(4, 4)));
+
+    // the tiled product of random rows: two tiles and a length which is not a multiple of the depth
+    const std::size_t count = 2 * CorrelationEngine::tile;
+    const std::size_t length = 3 * CorrelationEngine::depth + 17;
+    std::vector<double> rows(count * length);
+    for (double& value : rows)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        value = static_cast<double>(state >> 11) / 9007199254740992.0 * 2.0 - 1.0;
+    }
+    std::vector<double> tiled(count * count, -7.0);
+    std::vector<double> naive(count * count, -7.0);
+    CorrelationEngine::multiply(rows.data(), count, length, tiled.data(), 3);
+    CorrelationEngine::multiply_naive(rows.data(), count, length, naive.data());
+    bool all_close = true;
+    for (std::size_t i = 0; i < tiled.size(); i++)
+    {
+        all_close = all_close && std::fabs(tiled[i] - naive[i]) <= 1e-9;
+    }
+    CHECK(all_close);
+
+    // quotes spanning exactly as many steps as a grid may have, one step more is rejected
+    SymbolId wide = SymbolDictionary::global().intern("CORR WIDE");
+    std::int64_t limit = static_cast<std::int64_t>(CorrelationEngine::max_grid_values / CorrelationEngine::padded(1));
+    OrderTable spans;
+    spans.processOrder(Order(wide, 900, 1100, 0, 1, 1, 0, 0, UpdateType::ChangeToBid, 20150420, start));
+    spans.processOrder(Order(wide, 900, 1100, 0, 1, 1, 0, 0, UpdateType::ChangeToBid, 20150420, start + limit));
+    TimeIndex wide_index = TimeIndex::build(spans);
+    CHECK(CorrelationEngine::common_grid(wide_index, {wide}, 2).points == static_cast<std::size_t>(limit / 2 + 1));
+    std::cerr<<"(an error about the correlation grid is expected)"<<std::endl;
+    CHECK(CorrelationEngine::common_grid(wide_index, {wide}, 1).points == 0); // limit + 1 points
+}
+
+static void test_metric_sets()
+{
+    /* A table with a reduced metric set gives the selected statistics of the full one, the others stay 0 */
+    using ReducedTable = BasicOrderTable<Metrics::TradeGaps | Metrics::Spreads>;
+    std::vector<SymbolId> symbols = test_symbols(7);
+    std::vector<Order> orders = generated_orders(symbols, 5000, 23);
+    OrderTable full;
+    ReducedTable reduced;
+    for (const Order& order : orders)
+    {
+        full.processOrder(order);
+        reduced.processOrder(order);
+    }
+    CHECK(reduced.getTotalOrders() == full.getTotalOrders() && reduced.getSymbolsNum() == full.getSymbolsNum());
+    bool selected_equal = true;
+    bool others_zero = true;
+    bool full_nonzero = true; // the left out metrics do occur in the input
+    for (SymbolId id : full.get_symbol_ids())
+    {
+        const OrderBook& a = full.get_book(id);
+        const ReducedTable::Book& b = reduced.get_book(id);
+        selected_equal = selected_equal && a.get_mean_time_trades() == b.get_mean_time_trades()
+                      && a.get_median_time_trades() == b.get_median_time_trades()
+                      && a.get_longest_time_trades() == b.get_longest_time_trades()
+                      && a.get_mean_spread() == b.get_mean_spread() && a.get_median_spread() == b.get_median_spread();
+        others_zero = others_zero && b.get_mean_time_tick() == 0.0 && b.get_median_time_tick() == 0.0
+                   && b.get_longest_time_tick() == 0.0 && b.get_price_digits().total() == 0
+                   && b.get_volume_digits().total() == 0;
+        full_nonzero = full_nonzero && a.get_longest_time_tick() > 0.0 && a.get_price_digits().total() > 0;
+    }
+    CHECK(selected_equal);
+    CHECK(others_zero && full_nonzero);
+
+    // the columns of the left out metrics are left out of the output as well
+    std::string header;
+    SummaryFormatter::append_header<Metrics::TradeGaps | Metrics::Spreads>(header);
+    CHECK(header.find("Trade Time") != std::string::npos && header.find("Spread") != std::string::npos
+          && header.find("Tick Time") == std::string::npos);
+}
+
+static void test_order_merger()
+{
+    /* The merged stream is sorted by time, equal times go in the order of the sources, each source keeps its order */
+    SymbolId symbol = SymbolDictionary::global().intern("MERGE NO Equity");
+    const std::size_t sources = 3;
+    const std::size_t per_source = 10000; // several batches per source
+    auto read = [&](std::size_t index, OrderMerger::Output& output)
+    {
+        for (std::size_t i = 0; i < per_source; i++)
+        {
+            std::int64_t time = static_cast<std::int64_t>(i * (index + 1) / 2); // equal times within and across sources
+            output.push(Order(symbol, static_cast<std::int64_t>(index), 0, static_cast<std::int64_t>(i), 0, 0, 0, 0,
+                              UpdateType::Trade, 20150420, time));
+        }
+    };
+    std::vector<Order> merged;
+    {
+        OrderMerger merger(sources, read);
+        merger.merge([&merged](const Order& order) { merged.push_back(order); });
+    }
+    CHECK(merged.size() == sources * per_source);
+    bool ordered = true;
+    std::vector<std::int64_t> next(sources, 0); // next sequence number of every source
+    for (std::size_t i = 0; i < merged.size(); i++)
+    {
+        std::size_t source = static_cast<std::size_t>(merged[i].getBidTicks());
+        ordered = ordered && merged[i].getTradeTicks() == next[source]++;
+        if (i > 0)
+        {
+            const Order& previous = merged[i - 1];
+            ordered = ordered && (previous.getTime() < merged[i].getTime()
+                                  || (previous.getTime() == merged[i].getTime() && previous.getBidTicks() <= merged[i].getBidTicks()));
+        }
+    }
+    CHECK(ordered);
+
+    std::size_t limited = 0;
+    {
+        OrderMerger merger(sources, read);
+        merger.merge([&limited](const Order&) { limited++; }, 100);
+    }
+    CHECK(limited == 100);
+
+    // whole files through the parser: the orders of both files are merged, the limit counts the merged orders
+    std::string first = temporary_path("merge_1.csv");
+    std::string second = temporary_path("merge_2.csv");
+    write_text(first, input_line("MERGE A", 10, 11, 10.5, 1, 20150420, 100) + input_line("MERGE A", 10, 11, 10.5, 1, 20150420, 300));
+    write_text(second, input_line("MERGE A", 10, 11, 10.5, 1, 20150420, 200) + input_line("MERGE A", 10, 11, 10.5, 1, 20150420, 400));
+    DataParser all({first, second}, 0);
+    all.start(ReaderMode::Merged);
+    SymbolId merged_symbol = SymbolDictionary::global().intern("MERGE A");
+    const OrderBook& book = all.get_orders_table().get_book(merged_symbol);
+    CHECK(book.get_orders_num() == 4 && book.get_longest_time_trades() == 100.0);
+    DataParser limited_parser({first, second}, 3);
+    limited_parser.test_start(ReaderMode::Merged);
+    const OrderBook& limited_book = limited_parser.get_orders_table().get_book(merged_symbol);
+    CHECK(limited_book.get_orders_num() == 3 && limited_book.get_mean_time_trades() == 100.0);
+
+    // a rejected row does not count towards the limit: the first 3 merged orders are those at 100, 200 and 300
+    write_text(first, input_line("MERGE B", 10, 11, 10.5, 1, 20150420, 100) + input_line("MERGE B", 0, 0, 43, 8, 20150420, 150, "")
+                    + input_line("MERGE B", 10, 11, 10.5, 1, 20150420, 200) + input_line("MERGE B", 10, 11, 10.5, 1, 20150420, 300));
+    write_text(second, input_line("MERGE B", 10, 11, 10.5, 1, 20150420, 400) + input_line("MERGE B", 10, 11, 10.5, 1, 20150420, 500));
+    DataParser rejected_parser({first, second}, 3);
+    rejected_parser.test_start(ReaderMode::Merged);
+    const OrderBook& rejected_book = rejected_parser.get_orders_table().get_book(SymbolDictionary::global().intern("MERGE B"));
+    CHECK(rejected_book.get_orders_num() == 3 && rejected_book.get_longest_time_trades() == 100.0);
+    std::filesystem::remove(first);
+    std::filesystem::remove(second);
+}
+
+static void test_checkpoint()
+{
+    /* A table resumed from the checkpoint of the first half gives the statistics of a run over both halves */
+    std::vector<SymbolId> symbols = test_symbols(5);
+    std::vector<Order> orders = generated_orders(symbols, 4000, 5);
+    std::string path = temporary_path("checkpoint");
+    for (StatisticsMode mode : {StatisticsMode::Exact, StatisticsMode::Approximate})
+    {
+        BookOptions options(mode);
+        options.windows = {60 * Timestamp::nanoseconds_per_second, 300 * Timestamp::nanoseconds_per_second};
+        options.window_capacity = 64; // some events are truncated
+        OrderTable whole(options);
+        OrderTable first(options);
+        for (std::size_t i = 0; i < orders.size(); i++)
+        {
+            whole.processOrder(orders[i]);
+            if (i < orders.size() / 2)
+            {
+                first.processOrder(orders[i]);
+            }
+        }
+        CHECK(first.save_checkpoint(path));
+        OrderTable resumed(options);
+        CHECK(resumed.load_checkpoint(path));
+        for (std::size_t i = orders.size() / 2; i < orders.size(); i++)
+        {
+            resumed.processOrder(orders[i]);
+        }
+        CHECK(same_summaries(whole.get_summaries(), resumed.get_summaries()));
+        CHECK(whole.getTotalOrders() == resumed.getTotalOrders());
+        bool all_equal = true;
+        for (SymbolId id : whole.get_symbol_ids())
+        {
+            const OrderBook& a = whole.get_book(id);
+            const OrderBook& b = resumed.get_book(id);
+            all_equal = all_equal && a.get_percentile_spread(0.9) == b.get_percentile_spread(0.9)
+                     && a.get_percentile_time_trades(0.99) == b.get_percentile_time_trades(0.99)
+                     && a.get_price_digits().total() == b.get_price_digits().total();
+            for (std::size_t w = 0; w < a.get_windows_num(); w++)
+            {
+                WindowSummary x = a.get_window_summary(w);
+                WindowSummary y = b.get_window_summary(w);
+                all_equal = all_equal && x.trades == y.trades && x.ticks == y.ticks && x.quotes == y.quotes
+                         && x.mean_spread == y.mean_spread && x.median_time_tick == y.median_time_tick
+                         && x.truncated == y.truncated;
+            }
+        }
+        CHECK(all_equal);
+
+        BookOptions other = options;
+        other.window_capacity = 128;
+        OrderTable mismatched(other);
+        std::cerr<<"(an error about the checkpoint settings is expected)"<<std::endl;
+        CHECK(!mismatched.load_checkpoint(path));
+        CHECK(mismatched.getSymbolsNum() == 0);
+    }
+    std::filesystem::remove(path);
+}
 
-void run_tests()
+int run_tests()
 {
+    /* :returns the number of failed checks */
     std::cout<<"Tests are running"<<std::endl;
-}
\ No newline at end of file
+    test_running_statistics();
+    test_quantile_sketch();
+    test_delimiter_scanner();
+    test_parallel_ingest();
+    test_sharded_table();
+    test_parser();
+    test_order_cache();
+    test_follow();
+    test_rolling_window();
+    test_round_numbers();
+    test_civil_dates();
+    test_compressed_reader();
+    test_summary_formatter();
+    test_time_index();
+    test_correlation();
+    test_metric_sets();
+    test_order_merger();
+    test_checkpoint();
+    std::cout<<(failed_checks == 0 ? "All tests passed" : std::to_string(failed_checks) + " checks failed")<<std::endl;
+    return failed_checks;
+}
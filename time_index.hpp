@@ -0,0 +1,289 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <numeric>
+#include <algorithm>
+#include <limits>
+#include "order.hpp"
+#include "order_book.hpp"
+#include "sharded_order_table.hpp"
+
+class SortedTimes
+{
+    /* Sorted column of timestamps with a summary of its blocks.
+    The first time of every block of block_size entries is copied to "fences", a search looks up the block
+    in the fences (a small array which stays in the cache) and then only the block itself in the column,
+    so a lookup touches one block of the column instead of log2(n) scattered cache lines.
+    */
+    public:
+        static constexpr std::size_t block_size = 64;
+
+    private:
+        std::vector<std::int64_t> times;
+        std::vector<std::int64_t> fences; // times[k * block_size]
+
+        template <bool Upper>
+        static std::size_t search(const std::int64_t* begin, std::size_t size, std::int64_t time)
+        {
+            /* Branch-free binary search: the first position with an element > time (Upper) or >= time */
+            if (size == 0)
+            {
+                return 0;
+            }
+            const std::int64_t* base = begin;
+            while (size > 1)
+            {
+                std::size_t half = size / 2;
+                base = (Upper ? base[half] <= time : base[half] < time) ? base + half : base;
+                size -= half;
+            }
+            return static_cast<std::size_t>(base - begin) + (Upper ? *base <= time : *base < time);
+        }
+
+        template <bool Upper>
+        std::size_t bound(std::int64_t time) const
+        {
+            // the answer lies between the start of the block before the first greater fence and that fence
+            std::size_t block = search<Upper>(fences.data(), fences.size(), time);
+            if (block == 0)
+            {
+                return 0;
+            }
+            std::size_t begin = (block - 1) * block_size;
+            std::size_t size = std::min(block_size, times.size() - begin);
+            return begin + search<Upper>(times.data() + begin, size, time);
+        }
+
+    public:
+        void assign(std::vector<std::int64_t>&& sorted)
+        {
+            times = std::move(sorted);
+            fences.clear();
+            for (std::size_t i = 0; i < times.size(); i += block_size)
+            {
+                fences.push_back(times[i]);
+            }
+        }
+
+        std::size_t size() const { return times.size(); }
+
+        std::int64_t operator[](std::size_t index) const { return times[index]; }
+
+        const std::int64_t* data() const { return times.data(); }
+
+        std::size_t lower_bound(std::int64_t time) const { return bound<false>(time); }
+
+        std::size_t upper_bound(std::int64_t time) const { return bound<true>(time); }
+};
+
+struct QuoteSnapshot
+{
+    /* Top of the book carried by the latest order at or before the requested time */
+    std::int64_t time;      // nanoseconds, time of that order
+    std::int64_t bid_price; // ticks
+    std::int64_t ask_price; // ticks
+    std::uint32_t bid_volume;
+    std::uint32_t ask_volume;
+    double getBidPrice() const { return Order::to_price(bid_price); }
+    double getAskPrice() const { return Order::to_price(ask_price); }
+};
+
+struct TradeRange
+{
+    /* Trades of a time interval, views into the columns of the index in time order */
+    const std::int64_t* times = nullptr; // nanoseconds
+    const std::int64_t* prices = nullptr; // ticks
+    const std::uint32_t* volumes = nullptr;
+    std::size_t size = 0;
+    bool empty() const { return size == 0; }
+};
+
+class SymbolTimeIndex
+{
+    /* Point-in-time view of the retained orders of one book: every order as a quote, the trades separately,
+    each sorted by time (stably, orders with equal times keep the file order)
+    */
+    private:
+        SortedTimes quote_times;
+        std::vector<std::int64_t> bid_prices;
+        std::vector<std::int64_t> ask_prices;
+        std::vector<std::uint32_t> bid_volumes;
+        std::vector<std::uint32_t> ask_volumes;
+        SortedTimes trade_times;
+        std::vector<std::int64_t> trade_prices;
+        std::vector<std::uint32_t> trade_volumes;
+
+        template <typename Row>
+        void build(std::size_t rows, Row row)
+        {
+            std::vector<std::size_t> sequence(rows); // positions of the rows in time order
+            std::iota(sequence.begin(), sequence.end(), 0);
+            auto earlier = [&row](std::size_t a, std::size_t b) { return row(a).getTime() < row(b).getTime(); };
+            if (!std::is_sorted(sequence.begin(), sequence.end(), earlier))
+            {
+                std::stable_sort(sequence.begin(), sequence.end(), earlier);
+            }
+            std::vector<std::int64_t> quotes;
+            std::vector<std::int64_t> trades;
+            quotes.reserve(rows);
+            bid_prices.reserve(rows);
+            ask_prices.reserve(rows);
+            bid_volumes.reserve(rows);
+            ask_volumes.reserve(rows);
+            for (std::size_t index : sequence)
+            {
+                Order order = row(index);
+                quotes.push_back(order.getTime());
+                bid_prices.push_back(order.getBidTicks());
+                ask_prices.push_back(order.getAskTicks());
+                bid_volumes.push_back(order.getBidVolume());
+                ask_volumes.push_back(order.getAskVolume());
+                if (order.getType() == UpdateType::Trade)
+                {
+                    trades.push_back(order.getTime());
+                    trade_prices.push_back(order.getTradeTicks());
+                    trade_volumes.push_back(order.getTradeVolume());
+                }
+            }
+            quote_times.assign(std::move(quotes));
+            trade_times.assign(std::move(trades));
+        }
+
+    public:
+        SymbolTimeIndex() = default;
+
+        template <unsigned int Set>
+        explicit SymbolTimeIndex(const BasicOrderBook<Set>& book)
+        {
+            if (book.get_storage() == StorageMode::Columnar)
+            {
+                const OrderColumns& columns = book.get_columns();
+                build(columns.size(), [&columns, &book](std::size_t i) { return columns.row(i, book.getSymbolId()); });
+            }
+            else
+            {
+                const std::vector<Order>& orders = book.get_orders();
+                build(orders.size(), [&orders](std::size_t i) { return orders[i]; });
+            }
+        }
+
+        bool quote_at(std::int64_t time, QuoteSnapshot& quote) const
+        {
+            /* As-of lookup: the quote of the latest order at or before the time.
+            :returns false if the book has no order up to the time
+            */
+            std::size_t position = quote_times.upper_bound(time);
+            if (position == 0)
+            {
+                return false;
+            }
+            position--;
+            quote = QuoteSnapshot{quote_times[position], bid_prices[position], ask_prices[position],
+                                  bid_volumes[position], ask_volumes[position]};
+            return true;
+        }
+
+        TradeRange trades_between(std::int64_t begin, std::int64_t end) const
+        {
+            /* Trades with begin <= time <= end */
+            TradeRange range;
+            std::size_t first = trade_times.lower_bound(begin);
+            std::size_t last = trade_times.upper_bound(end);
+            if (first >= last)
+            {
+                return range;
+            }
+            range.times = trade_times.data() + first;
+            range.prices = trade_prices.data() + first;
+            range.volumes = trade_volumes.data() + first;
+            range.size = last - first;
+            return range;
+        }
+
+        void sample_mids(std::int64_t start, std::int64_t step, std::size_t points, double* mids) const
+        {
+            /* As-of join with the grid start + k * step: mids[k] is the mid price (ticks) of the latest order
+            at or before the k-th grid time, NaN before the first order. One merge pass over the quotes
+            */
+            std::size_t position = 0; // quotes up to the current grid time
+            const std::size_t quotes = quote_times.size();
+            for (std::size_t k = 0; k < points; k++)
+            {
+                std::int64_t time = start + static_cast<std::int64_t>(k) * step;
+                while (position < quotes && quote_times[position] <= time)
+                {
+                    position++;
+                }
+                mids[k] = position == 0 ? std::numeric_limits<double>::quiet_NaN()
+                                        : 0.5 * static_cast<double>(bid_prices[position - 1] + ask_prices[position - 1]);
+            }
+        }
+
+        std::int64_t getFirstTime() const { return quote_times.size() == 0 ? 0 : quote_times[0]; }
+
+        std::int64_t getLastTime() const { return quote_times.size() == 0 ? 0 : quote_times[quote_times.size() - 1]; }
+
+        std::size_t getQuotesNum() const { return quote_times.size(); }
+
+        std::size_t getTradesNum() const { return trade_times.size(); }
+};
+
+class TimeIndex
+{
+    /* Point-in-time queries over a loaded order table: as-of quotes and trade ranges in O(log n) per symbol.
+    The index is built once from the retained orders (StorageMode::Rows or Columnar, a StatsOnly table has none)
+    and is independent of the table afterwards; it does not see the orders added after the build.
+    */
+    private:
+        std::vector<SymbolTimeIndex> symbols; // indexed by SymbolId
+
+    public:
+        template <unsigned int Set>
+        void add(const BasicOrderBook<Set>& book)
+        {
+            if (symbols.size() <= book.getSymbolId())
+            {
+                symbols.resize(book.getSymbolId() + 1);
+            }
+            symbols[book.getSymbolId()] = SymbolTimeIndex(book);
+        }
+
+        template <unsigned int Set>
+        static TimeIndex build(const BasicOrderTable<Set>& table)
+        {
+            TimeIndex index;
+            for (SymbolId id : table.get_symbol_ids())
+            {
+                index.add(table.get_book(id));
+            }
+            return index;
+        }
+
+        template <unsigned int Set>
+        static TimeIndex build(const BasicShardedOrderTable<Set>& table)
+        {
+            TimeIndex index;
+            for (const BasicOrderBook<Set>* book : table.get_books())
+            {
+                index.add(*book);
+            }
+            return index;
+        }
+
+        bool quote_at(SymbolId symbol, std::int64_t time, QuoteSnapshot& quote) const
+        {
+            return symbol < symbols.size() && symbols[symbol].quote_at(time, quote);
+        }
+
+        TradeRange trades_between(SymbolId symbol, std::int64_t begin, std::int64_t end) const
+        {
+            return symbol < symbols.size() ? symbols[symbol].trades_between(begin, end) : TradeRange();
+        }
+
+        const SymbolTimeIndex* get_symbol(SymbolId symbol) const
+        {
+            return symbol < symbols.size() ? &symbols[symbol] : nullptr;
+        }
+};
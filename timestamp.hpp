@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+class Timestamp
+{
+    /* Conversion of the date (yyyymmdd) and time (seconds after midnight) columns to nanoseconds since the epoch.
+    The dates follow the proleptic Gregorian calendar, the times are taken as UTC.
+    */
+    public:
+        static constexpr std::int64_t nanoseconds_per_second = 1000000000;
+        static constexpr std::int64_t nanoseconds_per_day = 86400 * nanoseconds_per_second;
+
+        static constexpr std::int64_t days_from_civil(std::int64_t year, unsigned int month, unsigned int day)
+        {
+            /* Number of days since 1970-01-01 (negative before it), exact for all years and month lengths.
+            The year is shifted to start in March, so the leap day is the last day of the shifted year.
+            */
+            year -= month <= 2;
+            const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+            const unsigned int year_of_era = static_cast<unsigned int>(year - era * 400);                 // [0, 399]
+            const unsigned int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+            const unsigned int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+            return era * 146097 + static_cast<std::int64_t>(day_of_era) - 719468;
+        }
+
+        static constexpr std::int64_t midnight(std::uint32_t date)
+        {
+            /* :param date as 20150420
+            :returns the nanoseconds since the epoch at the beginning of the date
+            */
+            return days_from_civil(date / 10000, (date / 100) % 100, date % 100) * nanoseconds_per_day;
+        }
+};
+
+static_assert(Timestamp::days_from_civil(1970, 1, 1) == 0, "the epoch is day 0");
+static_assert(Timestamp::days_from_civil(2000, 3, 1) == 11017, "leap year 2000");
+static_assert(Timestamp::days_from_civil(2015, 4, 20) == 16545, "date of Sample_data.txt");
+
+class DateCache
+{
+    /* Per-thread cache of the midnight of the last date: the rows of one date come in long runs,
+    so the calendar computation runs only when the date changes
+    */
+    private:
+        std::uint32_t last_date = 0;
+        std::int64_t last_midnight = 0;
+
+    public:
+        std::int64_t midnight(std::uint32_t date)
+        {
+            if (date != last_date)
+            {
+                last_midnight = Timestamp::midnight(date);
+                last_date = date;
+            }
+            return last_midnight;
+        }
+
+        std::int64_t timestamp(std::uint32_t date, std::int64_t time_of_day)
+        {
+            /* :param time_of_day in nanoseconds after midnight */
+            return midnight(date) + time_of_day;
+        }
+};